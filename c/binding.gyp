@@ -0,0 +1,19 @@
+{
+  "targets": [
+    {
+      "target_name": "picofeed",
+      "sources": ["picofeed_node.c", "picofeed.c"],
+      "cflags": ["-O2", "-pthread", "<!@(pkg-config --cflags monocypher)"],
+      "ldflags": ["-pthread"],
+      "libraries": ["<!@(pkg-config --libs monocypher)"],
+      "conditions": [
+        ["OS=='linux'", { "libraries": ["-lrt"] }],
+        ["OS=='mac'", {
+          "xcode_settings": {
+            "OTHER_CFLAGS": ["-O2", "<!@(pkg-config --cflags monocypher)"]
+          }
+        }]
+      ]
+    }
+  ]
+}
@@ -1,13 +1,26 @@
 #include "picofeed.h"
 
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
 
 #define error_check(err) assert(0 == (err))
 
 #ifndef BENCH
 #define cpy(dst, src, size) memcpy((dst), (src), (size))
+#define mov(dst, src, size) memmove((dst), (src), (size))
 #define zro(ptr, size) memset((ptr), 0x0, (size))
 #define cmp(a, b, size) memcmp((a), (b), (size))
 #define ualloc(n) malloc((n))
@@ -15,45 +28,57 @@
 #define ralloc(ptr, n) realloc((ptr), (n))
 #else
 static struct stats_s {
-  int cpy;
-  size_t cpy_bytes;
+  _Atomic int cpy;
+  _Atomic size_t cpy_bytes;
+
+  _Atomic int mov;
+  _Atomic size_t mov_bytes;
 
-  int cmp;
-  size_t cmp_bytes;
+  _Atomic int cmp;
+  _Atomic size_t cmp_bytes;
 
-  int zro;
-  size_t zro_bytes;
+  _Atomic int zro;
+  _Atomic size_t zro_bytes;
 
-  int malloc;
-  size_t malloc_bytes;
+  _Atomic int malloc;
+  _Atomic size_t malloc_bytes;
 
-  int rlc;
-  size_t rlc_bytes;
+  _Atomic int rlc;
+  _Atomic size_t rlc_bytes;
 
-  int verify;
-  int pf_next;
+  _Atomic int verify;
+  _Atomic int pf_next;
 } stats = {0};
 
+/* counters are bumped from worker threads, order does not matter */
+#define stat_add(counter, n) atomic_fetch_add_explicit(&stats.counter, (n), memory_order_relaxed)
+
 #define cpy(dst, src, size) do { \
   memcpy((dst), (src), (size)); \
-  stats.cpy++; \
-  stats.cpy_bytes += (size); \
+  stat_add(cpy, 1); \
+  stat_add(cpy_bytes, (size)); \
+} while (0)
+
+#define mov(dst, src, size) do { \
+  memmove((dst), (src), (size)); \
+  stat_add(mov, 1); \
+  stat_add(mov_bytes, (size)); \
 } while (0)
 
 #define zro(ptr, size) do { \
   memset((ptr), 0x0, (size)); \
-  stats.zro++; \
-  stats.zro_bytes += (size); \
+  stat_add(zro, 1); \
+  stat_add(zro_bytes, (size)); \
 } while (0)
 
-#define ualloc(n) (stats.malloc++, stats.malloc_bytes += (n), malloc((n)))
-#define salloc(t, n) (stats.malloc++, stats.malloc_bytes += ((t) * (n)), calloc((t), (n)))
-#define ralloc(ptr, n) (stats.rlc++, stats.rlc_bytes += (n), realloc((ptr), (n)))
+#define ualloc(n) (stat_add(malloc, 1), stat_add(malloc_bytes, (n)), malloc((n)))
+#define salloc(t, n) (stat_add(malloc, 1), stat_add(malloc_bytes, ((t) * (n))), calloc((t), (n)))
+#define ralloc(ptr, n) (stat_add(rlc, 1), stat_add(rlc_bytes, (n)), realloc((ptr), (n)))
 
 static inline int
 cmp(const void *a, const void *b, size_t n) {
-  stats.cmp++;
-  stats.cmp_bytes += n;
+  stat_add(cmp, 1);
+  stat_add(cmp_bytes, n);
   return memcmp(a, b, n);
 }
 
@@ -61,6 +86,7 @@ void
 dump_stats(void) {
   printf("stats:\n");
   printf("CPY \t%i \t%zu B\n", stats.cpy, stats.cpy_bytes);
+  printf("MOV \t%i \t%zu B\n", stats.mov, stats.mov_bytes);
   printf("ZRO \t%i \t%zu B\n", stats.zro, stats.zro_bytes);
   printf("CMP \t%i \t%zu B\n", stats.cmp, stats.cmp_bytes);
   printf("ALC \t%i \t%zu B\n", stats.malloc, stats.malloc_bytes);
@@ -72,6 +98,21 @@ dump_stats(void) {
 
 /* ---------------- POP-01 Identity ----------------*/
 
+#if !defined(PICO_EXTERN_CRYPTO) || !defined(PICO_EXTERN_CRYPTO_IOV)
+/* gathers the segments for primitives that only sign contiguous messages */
+static uint8_t *
+iov_gather(const struct iovec *iov, int iovcnt, size_t *len) {
+  *len = 0;
+  for (int i = 0; i < iovcnt; ++i) *len += iov[i].iov_len;
+  uint8_t *buffer = ualloc(*len ? *len : 1);
+  if (buffer == NULL) return NULL;
+  for (size_t i = 0, o = 0; i < (size_t)iovcnt; o += iov[i++].iov_len) {
+    cpy(buffer + o, iov[i].iov_base, iov[i].iov_len);
+  }
+  return buffer;
+}
+#endif
+
 #ifndef PICO_EXTERN_CRYPTO
 #include <monocypher-ed25519.h>
 #include <sys/random.h>
@@ -82,8 +123,8 @@ pico_crypto_random(uint8_t *buffer, size_t size) {
   assert(n == (ssize_t)size);
 }
 
-void
-pico_public_from_secret(pf_key_t pk, const uint8_t seed[32]) {
+static void
+monocypher_public_key(pf_key_t pk, const uint8_t seed[32]) {
   uint8_t seed_copy[32] = {0};
   uint8_t secret[64] = {0};
 
@@ -92,13 +133,171 @@ pico_public_from_secret(pf_key_t pk, const uint8_t seed[32]) {
   zro(secret, sizeof(secret));
 }
 
-void
-pico_crypto_keypair(pf_keypair_t *pair) {
+static void
+monocypher_keypair(pf_keypair_t *pair) {
   uint8_t seed[32] = {0};
   pico_crypto_random(seed, sizeof(seed));
   crypto_ed25519_key_pair(pair->secret, pair->pk, seed);
 }
 
+static void
+monocypher_sign(
+  pf_signature_t signature,
+  const uint8_t *message,
+  const size_t m_len,
+  const pf_keypair_t *pair
+) {
+  crypto_ed25519_sign(signature, pair->secret, message, m_len);
+}
+
+static int
+monocypher_verify(
+  const pf_signature_t signature,
+  const uint8_t *message,
+  const size_t m_len,
+  const pf_key_t pk
+) {
+  return crypto_ed25519_check(signature, pk, message, m_len);
+}
+
+static int
+monocypher_verify_batch(const pf_verify_item_t *items, int n, int *results) {
+  int err = 0;
+  for (int i = 0; i < n; ++i) {
+    int r = crypto_ed25519_check(items[i].signature, items[i].pk, items[i].message, items[i].message_len);
+    if (results != NULL) results[i] = r;
+    if (r) err = -1;
+  }
+  return err;
+}
+
+static void
+sha512_iov(crypto_sha512_ctx *ctx, const struct iovec *iov, int iovcnt) {
+  for (int i = 0; i < iovcnt; ++i) {
+    crypto_sha512_update(ctx, iov[i].iov_base, iov[i].iov_len);
+  }
+}
+
+/* Streaming Ed25519 (RFC 8032), the message is hashed twice
+ * instead of being assembled in memory. */
+static void
+monocypher_sign_iov(
+  pf_signature_t signature,
+  const struct iovec *message,
+  const int iovcnt,
+  const pf_keypair_t *pair
+) {
+  crypto_sha512_ctx ctx;
+  uint8_t a[64];
+  uint8_t r[32];
+  uint8_t h[32];
+  uint8_t digest[64];
+
+  crypto_sha512(a, pair->seed, sizeof(pair->seed));
+  crypto_eddsa_trim_scalar(a, a);
+
+  crypto_sha512_init(&ctx);
+  crypto_sha512_update(&ctx, a + 32, 32);
+  sha512_iov(&ctx, message, iovcnt);
+  crypto_sha512_final(&ctx, digest);
+  crypto_eddsa_reduce(r, digest);
+  crypto_eddsa_scalarbase(signature, r);
+
+  crypto_sha512_init(&ctx);
+  crypto_sha512_update(&ctx, signature, 32);
+  crypto_sha512_update(&ctx, pair->pk, sizeof(pair->pk));
+  sha512_iov(&ctx, message, iovcnt);
+  crypto_sha512_final(&ctx, digest);
+  crypto_eddsa_reduce(h, digest);
+  crypto_eddsa_mul_add(signature + 32, h, a, r);
+
+  crypto_wipe(a, sizeof(a));
+  crypto_wipe(r, sizeof(r));
+  crypto_wipe(digest, sizeof(digest));
+}
+
+static int
+monocypher_verify_iov(
+  const pf_signature_t signature,
+  const struct iovec *message,
+  const int iovcnt,
+  const pf_key_t pk
+) {
+  crypto_sha512_ctx ctx;
+  uint8_t h[32];
+  uint8_t digest[64];
+  crypto_sha512_init(&ctx);
+  crypto_sha512_update(&ctx, signature, 32);
+  crypto_sha512_update(&ctx, pk, sizeof(pf_key_t));
+  sha512_iov(&ctx, message, iovcnt);
+  crypto_sha512_final(&ctx, digest);
+  crypto_eddsa_reduce(h, digest);
+  return crypto_eddsa_check_equation(signature, pk, h);
+}
+
+static const pf_crypto_backend_t monocypher_backend = {
+  .name = "monocypher",
+  .available = NULL,
+  .keypair = monocypher_keypair,
+  .sign = monocypher_sign,
+  .verify = monocypher_verify,
+  .verify_batch = monocypher_verify_batch,
+  .public_key = monocypher_public_key,
+  .sign_iov = monocypher_sign_iov,
+  .verify_iov = monocypher_verify_iov
+};
+
+static pthread_mutex_t backends_lock = PTHREAD_MUTEX_INITIALIZER;
+static const pf_crypto_backend_t *backends[PICOFEED_CRYPTO_BACKENDS] = { &monocypher_backend };
+static int nbackends = 1;
+static _Atomic(const pf_crypto_backend_t *) active_backend = &monocypher_backend;
+
+static inline int
+backend_available(const pf_crypto_backend_t *backend) {
+  return backend->available == NULL || backend->available();
+}
+
+int
+pico_crypto_register(const pf_crypto_backend_t *backend) {
+  int err = EFAILED;
+  if (backend == NULL || backend->name == NULL) return EFAILED;
+  pthread_mutex_lock(&backends_lock);
+  if (nbackends < PICOFEED_CRYPTO_BACKENDS) {
+    backends[nbackends++] = backend;
+    err = 0;
+  }
+  pthread_mutex_unlock(&backends_lock);
+  return err;
+}
+
+const pf_crypto_backend_t *
+pico_crypto_select(const char *name) {
+  const pf_crypto_backend_t *found = NULL;
+  pthread_mutex_lock(&backends_lock);
+  for (int i = nbackends - 1; i >= 0 && found == NULL; --i) {
+    if (name != NULL && 0 != strcmp(name, backends[i]->name)) continue;
+    if (backend_available(backends[i])) found = backends[i];
+  }
+  if (found != NULL) atomic_store(&active_backend, found);
+  pthread_mutex_unlock(&backends_lock);
+  return found;
+}
+
+const pf_crypto_backend_t *
+pico_crypto_backend(void) {
+  return atomic_load_explicit(&active_backend, memory_order_acquire);
+}
+
+void
+pico_public_from_secret(pf_key_t pk, const uint8_t seed[32]) {
+  pico_crypto_backend()->public_key(pk, seed);
+}
+
+void
+pico_crypto_keypair(pf_keypair_t *pair) {
+  pico_crypto_backend()->keypair(pair);
+}
+
 void
 pico_crypto_sign(
   pf_signature_t signature,
@@ -106,7 +305,7 @@ pico_crypto_sign(
   const size_t m_len,
   const pf_keypair_t pair
 ) {
-  crypto_ed25519_sign(signature, pair.secret, message, m_len);
+  pico_crypto_backend()->sign(signature, message, m_len, &pair);
 }
 
 int
@@ -117,9 +316,99 @@ pico_crypto_verify(
   const pf_key_t pk
 ) {
 #ifdef BENCH
-  stats.verify++;
+  stat_add(verify, 1);
 #endif
-  return crypto_ed25519_check(signature, pk, message, m_len);
+  return pico_crypto_backend()->verify(signature, message, m_len, pk);
+}
+
+int
+pico_crypto_verify_batch(const pf_verify_item_t *items, int n, int *results) {
+#ifdef BENCH
+  stat_add(verify, n);
+#endif
+  return pico_crypto_backend()->verify_batch(items, n, results);
+}
+
+void
+pico_crypto_sign_iov(
+  pf_signature_t signature,
+  const struct iovec *message,
+  const int iovcnt,
+  const pf_keypair_t pair
+) {
+  const pf_crypto_backend_t *backend = pico_crypto_backend();
+  if (backend->sign_iov != NULL) {
+    backend->sign_iov(signature, message, iovcnt, &pair);
+    return;
+  }
+
+  size_t len;
+  uint8_t *buffer = iov_gather(message, iovcnt, &len);
+  assert(buffer != NULL);
+  backend->sign(signature, buffer, len, &pair);
+  free(buffer);
+}
+
+int
+pico_crypto_verify_iov(
+  const pf_signature_t signature,
+  const struct iovec *message,
+  const int iovcnt,
+  const pf_key_t pk
+) {
+  const pf_crypto_backend_t *backend = pico_crypto_backend();
+#ifdef BENCH
+  stat_add(verify, 1);
+#endif
+  if (backend->verify_iov != NULL) return backend->verify_iov(signature, message, iovcnt, pk);
+
+  size_t len;
+  uint8_t *buffer = iov_gather(message, iovcnt, &len);
+  if (buffer == NULL) return -1;
+  int err = backend->verify(signature, buffer, len, pk);
+  free(buffer);
+  return err;
+}
+
+void
+pico_crypto_hash(
+  uint8_t *hash,
+  const size_t hash_size,
+  const uint8_t *key,
+  const size_t key_size,
+  const uint8_t *message,
+  const size_t m_len
+) {
+  crypto_blake2b_keyed(hash, hash_size, key, key_size, message, m_len);
+}
+#elif !defined(PICO_EXTERN_CRYPTO_IOV)
+void
+pico_crypto_sign_iov(
+  pf_signature_t signature,
+  const struct iovec *message,
+  const int iovcnt,
+  const pf_keypair_t pair
+) {
+  size_t len;
+  uint8_t *buffer = iov_gather(message, iovcnt, &len);
+  assert(buffer != NULL);
+  pico_crypto_sign(signature, buffer, len, pair);
+  free(buffer);
+}
+
+int
+pico_crypto_verify_iov(
+  const pf_signature_t signature,
+  const struct iovec *message,
+  const int iovcnt,
+  const pf_key_t pk
+) {
+  size_t len;
+  uint8_t *buffer = iov_gather(message, iovcnt, &len);
+  if (buffer == NULL) return -1;
+  int err = pico_crypto_verify(signature, buffer, len, pk);
+  free(buffer);
+  return err;
 }
 #endif /* PICO_EXTERN_CRYPTO */
 
@@ -141,6 +430,13 @@ ensure_pair_pk(pf_keypair_t *pair) {
   }
 }
 
+/* clears key material, volatile so the store is not elided before free() */
+static void
+wipe_pair(pf_keypair_t *pair) {
+  volatile uint8_t *p = (volatile uint8_t *)pair;
+  for (size_t i = 0; i < sizeof(*pair); ++i) p[i] = 0;
+}
+
 /* ---------------- POP-02 Format ----------------*/
 
 #define _HDR_U16 0x10
@@ -208,16 +504,22 @@ pf_header_size(pf_header_id_t id) {
   return EUNKHDR;
 }
 
-void
-pf_header_begin(pf_header_iter_t *iter, const pf_block_t *block) {
+static void
+header_begin(pf_header_iter_t *iter, const uint8_t *bytes, const uint8_t *body) {
   zro(iter, sizeof(*iter));
-  if (block == NULL || block->bytes == NULL || block->body == NULL) return;
+  if (bytes == NULL || body == NULL) return;
 
-  int vo = varint_decode(block->bytes + sizeof(pf_signature_t), NULL);
+  int vo = varint_decode(bytes + sizeof(pf_signature_t), NULL);
   if (vo <= 0) return;
 
-  iter->cursor = block->bytes + sizeof(pf_signature_t) + (size_t)vo;
-  iter->end = block->body;
+  iter->cursor = bytes + sizeof(pf_signature_t) + (size_t)vo;
+  iter->end = body;
+}
+
+void
+pf_header_begin(pf_header_iter_t *iter, const pf_block_t *block) {
+  if (block == NULL) zro(iter, sizeof(*iter));
+  else header_begin(iter, block->bytes, block->body);
 }
 
 int
@@ -251,20 +553,27 @@ pf_block_header(const pf_block_t *block, pf_header_id_t id) {
   return NULL;
 }
 
-int
-pf_decode_block(const uint8_t *bytes, pf_block_t *block, int no_verify) {
-  uint8_t headers_set[_HDR_MAX] = {0};
-  zro(block, sizeof(pf_block_t));
-  cpy(block->id, bytes, sizeof(pf_signature_t));
-  block->bytes = bytes;
+#define PF_AUTHOR_FIELD (PF_HDR_PREFIX_SIZE + sizeof(pf_key_t))
+#define PF_PSIG_FIELD (PF_HDR_PREFIX_SIZE + sizeof(pf_signature_t))
 
-  size_t data_size = 0;
-  int vo = varint_decode(bytes + sizeof(pf_signature_t), &data_size);
-  if (vo <= 0) return EFAILED;
+/**
+ * Recognizes the layout written by pf_append(): AUTHOR, optional PSIG,
+ * optional SKIP, body.
+ * @return body offset or 0 when the generic parser must be used */
+static inline size_t
+decode_canonical(const uint8_t *bytes, size_t o, size_t end) {
+  if (o + PF_AUTHOR_FIELD > end || bytes[o] != 0 || bytes[o + 1] != HDR_AUTHOR) return 0;
+  o += PF_AUTHOR_FIELD;
+  if (o + PF_PSIG_FIELD <= end && bytes[o] == 0 && bytes[o + 1] == HDR_PSIG) o += PF_PSIG_FIELD;
+  if (o + PF_PSIG_FIELD <= end && bytes[o] == 0 && bytes[o + 1] == HDR_SKIP) o += PF_PSIG_FIELD;
+  if (o < end && bytes[o] == 0) return 0;
+  return o;
+}
 
-  size_t o = sizeof(pf_signature_t) + (size_t)vo;
-  size_t end = o + data_size;
-  if (end < o) return EFAILED;
+static int
+decode_headers(const uint8_t *bytes, size_t *offset, size_t end, pf_block_view_t *view) {
+  uint64_t headers_set[_HDR_MAX / 64] = {0};
+  size_t o = *offset;
 
   while (o < end && bytes[o] == 0) {
     pf_header_id_t id;
@@ -274,31 +583,94 @@ pf_decode_block(const uint8_t *bytes, pf_block_t *block, int no_verify) {
     id = bytes[o + 1];
     n = pf_header_size(id);
     if (n < 0) return n;
-    if (id < _HDR_MAX && headers_set[id]++) return EDUPHDR;
+    if (id < _HDR_MAX) {
+      const uint64_t bit = (uint64_t)1 << (id & 63);
+      if (headers_set[id >> 6] & bit) return EDUPHDR;
+      headers_set[id >> 6] |= bit;
+    }
+    if (id == HDR_AUTHOR) view->author = bytes + o + PF_HDR_PREFIX_SIZE;
+    else if (id == HDR_PSIG) view->psig = bytes + o + PF_HDR_PREFIX_SIZE;
 
     o += PF_HDR_PREFIX_SIZE + (size_t)n;
     if (o > end) return EFAILED;
   }
 
-  if (o > end) return EFAILED;
+  *offset = o;
+  return 0;
+}
+
+int
+pf_decode_view(const uint8_t *bytes, pf_block_view_t *view, int no_verify) {
+  view->id = bytes;
+  view->author = NULL;
+  view->psig = NULL;
+  view->verified = 0;
+
+  size_t data_size = 0;
+  int vo = varint_decode(bytes + sizeof(pf_signature_t), &data_size);
+  if (vo <= 0) return EFAILED;
+
+  size_t o = sizeof(pf_signature_t) + (size_t)vo;
+  size_t end = o + data_size;
+  if (end < o) return EFAILED;
+
+  size_t body = decode_canonical(bytes, o, end);
+  if (body) {
+    view->author = bytes + o + PF_HDR_PREFIX_SIZE;
+    if (body - o > PF_AUTHOR_FIELD) view->psig = view->author + PF_AUTHOR_FIELD;
+    o = body;
+  } else {
+    int err = decode_headers(bytes, &o, end, view);
+    if (err) return err;
+  }
 
-  block->body = bytes + o;
-  block->len = end - o;
-  block->block_size = end;
+  view->body = bytes + o;
+  view->len = end - o;
+  view->block_size = end;
 
   if (!no_verify) {
-    const pf_key_t *author = pf_block_header(block, HDR_AUTHOR);
-    if (author == NULL) return EVERFAIL;
+    if (view->author == NULL) return EVERFAIL;
     if (0 != pico_crypto_verify(
-      block->id,
+      bytes,
       bytes + sizeof(pf_signature_t),
-      block->block_size - sizeof(pf_signature_t),
-      *author
+      end - sizeof(pf_signature_t),
+      view->author
     )) return EVERFAIL;
-    block->verified = 1;
+    view->verified = 1;
+  }
+
+  return (int)end;
+}
+
+/* copies a successfully decoded view into an owned block */
+static void
+block_from_view(pf_block_t *block, const pf_block_view_t *view) {
+  cpy(block->id, view->id, sizeof(pf_signature_t));
+  block->bytes = view->id;
+  block->body = view->body;
+  block->len = view->len;
+  block->block_size = view->block_size;
+  block->verified = view->verified;
+}
+
+int
+pf_decode_block(const uint8_t *bytes, pf_block_t *block, int no_verify) {
+  pf_block_view_t view;
+  int n = pf_decode_view(bytes, &view, no_verify);
+
+  /* every field is written, no zero-fill on the hot path */
+  if (n < 0) {
+    cpy(block->id, bytes, sizeof(pf_signature_t));
+    block->bytes = bytes;
+    block->body = NULL;
+    block->len = 0;
+    block->block_size = 0;
+    block->verified = view.verified;
+    return n;
   }
 
-  return (int)block->block_size;
+  block_from_view(block, &view);
+  return n;
 }
 
 ssize_t
@@ -331,31 +703,22 @@ pf_sizeof(size_t body_len, const pf_header_t *headers, size_t nheaders) {
   return sizeof(pf_signature_t) + varint_sizeof(data_size) + data_size;
 }
 
-ssize_t
-pf_create_block(
+/**
+ * Writes size and headers after the signature slot
+ * @return offset of body or < 0 on error */
+static ssize_t
+encode_prefix(
   uint8_t *dst,
-  const uint8_t *body,
   size_t body_len,
   const pf_header_t *headers,
   size_t nheaders,
-  pf_keypair_t pair
+  const pf_keypair_t *pair
 ) {
-  ssize_t block_size;
-  ssize_t headers_size;
-  size_t data_size;
   size_t o = sizeof(pf_signature_t);
-
-  if (body == NULL || body_len == 0) return EFAILED;
-  if (body[0] == 0) return EFAILED;
-
-  ensure_pair_pk(&pair);
-  block_size = pf_sizeof(body_len, headers, nheaders);
-  if (block_size < 0) return block_size;
-  headers_size = pf_sizeof_headers(headers, nheaders);
+  ssize_t headers_size = pf_sizeof_headers(headers, nheaders);
   if (headers_size < 0) return headers_size;
 
-  data_size = body_len + (size_t)headers_size;
-  o += varint_encode(&dst[o], data_size);
+  o += varint_encode(&dst[o], body_len + (size_t)headers_size);
 
   for (size_t i = 0; i < nheaders; ++i) {
     int n = pf_header_size(headers[i].id);
@@ -364,12 +727,173 @@ pf_create_block(
     dst[o++] = 0;
     dst[o++] = headers[i].id;
 
-    if (headers[i].id == HDR_AUTHOR) cpy(&dst[o], pair.pk, sizeof(pair.pk));
+    if (headers[i].id == HDR_AUTHOR) cpy(&dst[o], pair->pk, sizeof(pair->pk));
     else cpy(&dst[o], headers[i].value, (size_t)n);
 
     o += (size_t)n;
   }
 
+  return (ssize_t)o;
+}
+
+ssize_t
+pf_create_block_iov(
+  uint8_t *dst,
+  const struct iovec *body,
+  int iovcnt,
+  const pf_header_t *headers,
+  size_t nheaders,
+  pf_keypair_t pair
+) {
+  struct iovec local[8];
+  struct iovec *msg = local;
+  size_t body_len = 0;
+  ssize_t prefix_size;
+  int first = -1;
+
+  if (body == NULL || iovcnt <= 0) return EFAILED;
+  for (int i = 0; i < iovcnt; ++i) {
+    if (first < 0 && body[i].iov_len) first = i;
+    body_len += body[i].iov_len;
+  }
+  if (first < 0) return EFAILED;
+  if (((const uint8_t*)body[first].iov_base)[0] == 0) return EFAILED;
+
+  ensure_pair_pk(&pair);
+  const ssize_t size = pf_sizeof(body_len, headers, nheaders);
+  if (size < 0) return size;
+  prefix_size = encode_prefix(dst, body_len, headers, nheaders, &pair);
+  if (prefix_size < 0) return prefix_size;
+
+  if ((size_t)iovcnt + 1 > sizeof(local) / sizeof(local[0])) {
+    msg = ualloc(((size_t)iovcnt + 1) * sizeof(struct iovec));
+    if (msg == NULL) return EFAILED;
+  }
+  msg[0].iov_base = dst + sizeof(pf_signature_t);
+  msg[0].iov_len = (size_t)prefix_size - sizeof(pf_signature_t);
+  cpy(&msg[1], body, (size_t)iovcnt * sizeof(struct iovec));
+
+  pico_crypto_sign_iov(dst, msg, iovcnt + 1, pair);
+  if (msg != local) free(msg);
+  return prefix_size;
+}
+
+typedef struct {
+  const struct iovec *iov;
+  int iovcnt;
+  int i;
+  size_t offset;
+} iov_cursor_t;
+
+/* Copies up to n bytes to dst (or skips them when dst is NULL)
+ * @return number of bytes consumed */
+static size_t
+iov_read(iov_cursor_t *c, uint8_t *dst, size_t n) {
+  size_t done = 0;
+  while (done < n && c->i < c->iovcnt) {
+    size_t avail = c->iov[c->i].iov_len - c->offset;
+    size_t take = avail < n - done ? avail : n - done;
+    if (dst != NULL) cpy(dst + done, (const uint8_t*)c->iov[c->i].iov_base + c->offset, take);
+    done += take;
+    c->offset += take;
+    if (c->offset == c->iov[c->i].iov_len) {
+      c->i++;
+      c->offset = 0;
+    }
+  }
+  return done;
+}
+
+ssize_t
+pf_verify_block_iov(const struct iovec *block, int iovcnt) {
+  uint8_t headers_set[_HDR_MAX] = {0};
+  iov_cursor_t c = { .iov = block, .iovcnt = iovcnt };
+  struct iovec local[8];
+  struct iovec *msg = local;
+  pf_signature_t id;
+  pf_key_t author;
+  int has_author = 0;
+  uint8_t varint[10] = {0};
+  size_t total = 0;
+  size_t data_size = 0;
+  size_t o, end, skip;
+  int vo, n, start, err;
+
+  if (block == NULL || iovcnt <= 0) return EFAILED;
+  for (int i = 0; i < iovcnt; ++i) total += block[i].iov_len;
+
+  if (iov_read(&c, id, sizeof(id)) != sizeof(id)) return EFAILED;
+  n = (int)iov_read(&c, varint, sizeof(varint));
+  vo = varint_decode(varint, &data_size);
+  if (vo <= 0 || vo > n) return EFAILED;
+
+  o = sizeof(pf_signature_t) + (size_t)vo;
+  end = o + data_size;
+  if (end < o || end != total) return EFAILED;
+
+  /* rewind to first header */
+  c = (iov_cursor_t){ .iov = block, .iovcnt = iovcnt };
+  iov_read(&c, NULL, o);
+
+  while (o < end) {
+    uint8_t prefix[PF_HDR_PREFIX_SIZE];
+    if (iov_read(&c, prefix, 1) != 1 || prefix[0] != 0) break;
+    if (o + PF_HDR_PREFIX_SIZE > end) return EFAILED;
+    iov_read(&c, prefix + 1, 1);
+
+    n = pf_header_size(prefix[1]);
+    if (n < 0) return n;
+    if (prefix[1] < _HDR_MAX && headers_set[prefix[1]]++) return EDUPHDR;
+    o += PF_HDR_PREFIX_SIZE + (size_t)n;
+    if (o > end) return EFAILED;
+
+    if (prefix[1] == HDR_AUTHOR) has_author = iov_read(&c, author, sizeof(author)) == sizeof(author);
+    else iov_read(&c, NULL, (size_t)n);
+  }
+  if (!has_author) return EVERFAIL;
+
+  /* message is everything after the signature */
+  skip = sizeof(pf_signature_t);
+  for (start = 0; start < iovcnt && skip >= block[start].iov_len; ++start) {
+    skip -= block[start].iov_len;
+  }
+  if ((size_t)(iovcnt - start) > sizeof(local) / sizeof(local[0])) {
+    msg = ualloc((size_t)(iovcnt - start) * sizeof(struct iovec));
+    if (msg == NULL) return EFAILED;
+  }
+  cpy(msg, &block[start], (size_t)(iovcnt - start) * sizeof(struct iovec));
+  msg[0].iov_base = (uint8_t*)msg[0].iov_base + skip;
+  msg[0].iov_len -= skip;
+
+  err = pico_crypto_verify_iov(id, msg, iovcnt - start, author);
+  if (msg != local) free(msg);
+  if (err) return EVERFAIL;
+  return (ssize_t)end;
+}
+
+ssize_t
+pf_create_block(
+  uint8_t *dst,
+  const uint8_t *body,
+  size_t body_len,
+  const pf_header_t *headers,
+  size_t nheaders,
+  pf_keypair_t pair
+) {
+  ssize_t block_size;
+  ssize_t prefix_size;
+  size_t o;
+
+  if (body == NULL || body_len == 0) return EFAILED;
+  if (body[0] == 0) return EFAILED;
+
+  ensure_pair_pk(&pair);
+  block_size = pf_sizeof(body_len, headers, nheaders);
+  if (block_size < 0) return block_size;
+  prefix_size = encode_prefix(dst, body_len, headers, nheaders, &pair);
+  if (prefix_size < 0) return prefix_size;
+  o = (size_t)prefix_size;
+
   cpy(&dst[o], body, body_len);
   o += body_len;
   assert(o == (size_t)block_size);
@@ -397,52 +921,190 @@ block_psig(const pf_block_t *block) {
   return psig == NULL ? &PF_ZERO_SIG : psig;
 }
 
-#define PICOFEED_DEFAULT_CAPACITY 2048
+/* spare room for this many blocks of observed size when growing */
+#define PICOFEED_GROWTH_BLOCKS 4
+
+struct pf_digests_s {
+  size_t height;
+  size_t tail;
+  size_t capacity;
+  uint8_t chain[][PICOFEED_DIGEST_SIZE];
+};
 
 static inline void
 ensure_magic(const pico_feed_t *feed) {
   assert(feed != NULL);
   assert(feed->buffer != NULL);
   assert(feed->tail >= PICOFEED_MAGIC_SIZE);
+  assert(feed->head <= feed->tail);
   assert(0 == cmp(feed->buffer, PiC0, PICOFEED_MAGIC_SIZE));
 }
 
-static inline void
+/* offset of the oldest block, zero-initialized feeds start after the magic */
+static inline size_t
+feed_head(const pico_feed_t *feed) {
+  return feed->head > PICOFEED_MAGIC_SIZE ? feed->head : PICOFEED_MAGIC_SIZE;
+}
+
+static inline int
+feed_inline(const pico_feed_t *feed) {
+  return feed->buffer == feed->inline_buffer;
+}
+
+static inline size_t
+grow_capacity(size_t capacity, size_t min_capacity, size_t block_hint) {
+  const size_t spare = min_capacity + block_hint * PICOFEED_GROWTH_BLOCKS;
+  capacity <<= 1;
+  return capacity < spare ? spare : capacity;
+}
+
+static int
 grow(pico_feed_t *feed, size_t min_capacity) {
-  size_t capacity = feed->capacity ? feed->capacity : PICOFEED_DEFAULT_CAPACITY;
-  while (capacity < min_capacity) capacity <<= 1;
-  feed->buffer = ralloc(feed->buffer, capacity);
-  assert(feed->buffer != NULL);
+  const size_t capacity = grow_capacity(feed->capacity, min_capacity, feed->block_hint);
+
+  if (feed->flags & PF_FLAG_MAPPED) return EFAILED;
+
+  if (feed_inline(feed)) {
+    uint8_t *buffer = ualloc(capacity);
+    assert(buffer != NULL);
+    cpy(buffer, feed->buffer, feed->tail);
+    feed->buffer = buffer;
+  } else {
+    feed->buffer = ralloc(feed->buffer, capacity);
+    assert(feed->buffer != NULL);
+  }
   feed->capacity = capacity;
+  return 0;
+}
+
+/* running estimate of appended block sizes */
+static inline void
+observe_block(pico_feed_t *feed, size_t block_size) {
+  if (!feed->block_hint) feed->block_hint = block_size;
+  else feed->block_hint = (feed->block_hint * 3 + block_size + 3) >> 2;
+}
+
+/* moves retained blocks back to the front of the buffer */
+static void
+compact(pico_feed_t *feed) {
+  const size_t head = feed_head(feed);
+  const size_t delta = head - PICOFEED_MAGIC_SIZE;
+  if (!delta || (feed->flags & PF_FLAG_MAPPED)) return;
+
+  mov(feed->buffer + PICOFEED_MAGIC_SIZE, feed->buffer + head, feed->tail - head);
+  feed->tail -= delta;
+  feed->head = PICOFEED_MAGIC_SIZE;
+  if (feed->digests != NULL) feed->digests->tail -= delta;
 }
 
 void
 pf_init(pico_feed_t *feed) {
-  zro(feed, sizeof(*feed));
-  feed->capacity = PICOFEED_DEFAULT_CAPACITY;
-  feed->buffer = salloc(feed->capacity, 1);
-  assert(feed->buffer != NULL);
+  zro(feed, offsetof(pico_feed_t, inline_buffer));
+  feed->capacity = PICOFEED_INLINE_CAPACITY;
+  feed->buffer = feed->inline_buffer;
   cpy(feed->buffer, PiC0, PICOFEED_MAGIC_SIZE);
   feed->tail = PICOFEED_MAGIC_SIZE;
+  feed->head = PICOFEED_MAGIC_SIZE;
 }
 
 void
 pf_deinit(pico_feed_t *feed) {
-  free(feed->buffer);
-  zro(feed, sizeof(*feed));
+  free(feed->digests);
+  if (feed->flags & PF_FLAG_MAPPED) munmap(feed->buffer, feed->capacity);
+  else if (!feed_inline(feed)) free(feed->buffer);
+  zro(feed, offsetof(pico_feed_t, inline_buffer));
 }
 
-int
-pf_next(const pico_feed_t *feed, pf_iterator_t *iter) {
-#ifdef BENCH
-  stats.pf_next++;
-#endif
-  ensure_magic(feed);
+/* --------------- Rolling Digest ---------------*/
 
-  if (iter->offset == 0 && iter->idx == 0) {
-    iter->offset = PICOFEED_MAGIC_SIZE;
-    iter->idx = -1;
-  }
+static void
+digests_truncate(pico_feed_t *feed, size_t height, size_t tail) {
+  pf_digests_t *d = feed->digests;
+  if (d == NULL || d->height <= height) return;
+  d->height = height;
+  d->tail = tail;
+}
+
+/* extends the digest chain up to feed->tail */
+static pf_digests_t *
+digests_sync(pico_feed_t *feed) {
+  pf_digests_t *d = feed->digests;
+  uint8_t link[PICOFEED_DIGEST_SIZE + sizeof(pf_signature_t)];
+
+  ensure_magic(feed);
+  if (d == NULL) {
+    const size_t capacity = 16;
+    d = salloc(1, sizeof(*d) + capacity * PICOFEED_DIGEST_SIZE);
+    assert(d != NULL);
+    d->tail = feed_head(feed);
+    d->capacity = capacity;
+    feed->digests = d;
+  }
+
+  /* buffer was rewritten behind our back */
+  if (d->tail > feed->tail || d->tail < feed_head(feed)) {
+    d->height = 0;
+    d->tail = feed_head(feed);
+  }
+
+  while (d->tail < feed->tail) {
+    ssize_t n = pf_next_block_offset(&feed->buffer[d->tail]);
+    assert(n > 0);
+
+    if (d->height + 1 >= d->capacity) {
+      size_t capacity = d->capacity << 1;
+      d = ralloc(d, sizeof(*d) + capacity * PICOFEED_DIGEST_SIZE);
+      assert(d != NULL);
+      d->capacity = capacity;
+      feed->digests = d;
+    }
+
+    cpy(link, d->chain[d->height], PICOFEED_DIGEST_SIZE);
+    cpy(link + PICOFEED_DIGEST_SIZE, &feed->buffer[d->tail], sizeof(pf_signature_t));
+    pico_crypto_hash(d->chain[d->height + 1], PICOFEED_DIGEST_SIZE, NULL, 0, link, sizeof(link));
+    d->height++;
+    d->tail += (size_t)n;
+  }
+
+  return d;
+}
+
+int
+pf_digest(pico_feed_t *feed, uint8_t out[PICOFEED_DIGEST_SIZE]) {
+  const pf_digests_t *d = digests_sync(feed);
+  cpy(out, d->chain[d->height], PICOFEED_DIGEST_SIZE);
+  return (int)d->height;
+}
+
+int
+pf_digest_at(pico_feed_t *feed, int height, uint8_t out[PICOFEED_DIGEST_SIZE]) {
+  const pf_digests_t *d = digests_sync(feed);
+  if (height < 0) height = (int)d->height + height;
+  if (height < 0 || (size_t)height > d->height) return EBOUNDS;
+  cpy(out, d->chain[height], PICOFEED_DIGEST_SIZE);
+  return 0;
+}
+
+int
+pf_equal(pico_feed_t *a, pico_feed_t *b) {
+  if (a == b) return 1;
+  const pf_digests_t *da = digests_sync(a);
+  const pf_digests_t *db = digests_sync(b);
+  return da->height == db->height &&
+    0 == cmp(da->chain[da->height], db->chain[db->height], PICOFEED_DIGEST_SIZE);
+}
+
+int
+pf_next(const pico_feed_t *feed, pf_iterator_t *iter) {
+#ifdef BENCH
+  stat_add(pf_next, 1);
+#endif
+  ensure_magic(feed);
+
+  if (iter->offset == 0 && iter->idx == 0) {
+    iter->offset = feed_head(feed);
+    iter->idx = -1;
+  }
 
   if (iter->offset >= feed->tail) return 1;
 
@@ -457,12 +1119,34 @@ pf_next(const pico_feed_t *feed, pf_iterator_t *iter) {
   return 0;
 }
 
+int
+pf_next_view(const pico_feed_t *feed, pf_iterator_t *iter, pf_block_view_t *view) {
+#ifdef BENCH
+  stat_add(pf_next, 1);
+#endif
+  ensure_magic(feed);
+
+  if (iter->offset == 0 && iter->idx == 0) {
+    iter->offset = feed_head(feed);
+    iter->idx = -1;
+  }
+
+  if (iter->offset >= feed->tail) return 1;
+
+  int n = pf_decode_view(feed->buffer + iter->offset, view, iter->skip_verify);
+  if (n < 0) return n;
+
+  iter->offset += n;
+  ++iter->idx;
+  return 0;
+}
+
 int
 pf_len(const pico_feed_t *feed) {
   ensure_magic(feed);
 
   int len = 0;
-  ssize_t offset = PICOFEED_MAGIC_SIZE;
+  ssize_t offset = feed_head(feed);
 
   while (offset < (ssize_t)feed->tail) {
     int n = pf_next_block_offset(&feed->buffer[offset]);
@@ -490,9 +1174,10 @@ pf_get(const pico_feed_t *feed, pf_block_t *block, int idx) {
   if (idx < 0 || idx >= len) return EBOUNDS;
 
   pf_iterator_t iter = {0};
-  while (0 == pf_next(feed, &iter)) {
+  pf_block_view_t view;
+  while (0 == pf_next_view(feed, &iter, &view)) {
     if (iter.idx == idx) {
-      *block = iter.block;
+      block_from_view(block, &view);
       return 0;
     }
   }
@@ -500,6 +1185,88 @@ pf_get(const pico_feed_t *feed, pf_block_t *block, int idx) {
   return EBOUNDS;
 }
 
+int
+pf_prefix_hash(const pico_feed_t *feed, int height, uint8_t out[32]) {
+  ensure_magic(feed);
+
+  pf_iterator_t iter = {0};
+  pf_block_view_t view;
+  const size_t head = feed_head(feed);
+
+  if (height < 0) return EBOUNDS;
+  iter.skip_verify = 1;
+  for (int i = 0; i < height; ++i) {
+    int err = pf_next_view(feed, &iter, &view);
+    if (err) return err < 0 ? err : EBOUNDS;
+  }
+  pico_crypto_hash(out, 32, NULL, 0, feed->buffer + head, height ? iter.offset - head : 0);
+  return 0;
+}
+
+/* trusted_hash NULL when the caller already bound the prefix bytes */
+static int
+verify_from(const pico_feed_t *feed, int trusted_height, const pf_signature_t trusted_id, const uint8_t *trusted_hash) {
+  pf_iterator_t iter = {0};
+  pf_block_view_t view;
+  const uint8_t *prev = NULL;
+  int err;
+
+  /* blocks below the checkpoint are bound by the prefix hash,
+   * the checkpoint itself is verified like any later block */
+  iter.skip_verify = trusted_height > 1;
+  while (0 == (err = pf_next_view(feed, &iter, &view))) {
+    if (prev != NULL && (view.psig == NULL || 0 != cmp(view.psig, prev, sizeof(pf_signature_t)))) return EPARENT;
+    prev = view.id;
+
+    if (iter.idx == trusted_height - 1) {
+      if (0 != cmp(view.id, trusted_id, sizeof(pf_signature_t))) return EVERFAIL;
+      if (trusted_hash != NULL) {
+        uint8_t hash[32];
+        const size_t head = feed_head(feed);
+        pico_crypto_hash(hash, sizeof(hash), NULL, 0, feed->buffer + head, iter.offset - head);
+        if (0 != cmp(hash, trusted_hash, sizeof(hash))) return EVERFAIL;
+      }
+    }
+    iter.skip_verify = iter.idx + 1 < trusted_height - 1;
+  }
+
+  if (err < 0) return err;
+  if (iter.idx + 1 < trusted_height) return EBOUNDS;
+  return iter.idx + 1;
+}
+
+int
+pf_verify_from(const pico_feed_t *feed, int trusted_height, const pf_signature_t trusted_id, const uint8_t trusted_hash[32]) {
+  ensure_magic(feed);
+
+  if (trusted_height < 0) return EBOUNDS;
+  if (trusted_height > 0 && (trusted_id == NULL || trusted_hash == NULL)) return EFAILED;
+  return verify_from(feed, trusted_height, trusted_id, trusted_hash);
+}
+
+/* makes room for `size` bytes at feed->tail */
+static int
+reserve_block(pico_feed_t *feed, size_t size) {
+  if (feed->flags & PF_FLAG_MAPPED) return EFAILED;
+  if (feed->max_size) {
+    if (size > feed->max_size) return EBOUNDS;
+    while (feed->tail - feed_head(feed) + size > feed->max_size) pf_shift(feed, 1);
+  }
+
+  if (size > feed->capacity - feed->tail) compact(feed);
+  if (size > feed->capacity - feed->tail) return grow(feed, feed->tail + size);
+  return 0;
+}
+
+/* accepts a block written at feed->tail */
+static void
+commit_block(pico_feed_t *feed, size_t size) {
+  feed->tail += size;
+  observe_block(feed, size);
+  /* extend a current chain, a shifted one is rebuilt on demand */
+  if (feed->digests != NULL && feed->digests->tail + size == feed->tail) digests_sync(feed);
+}
+
 static ssize_t
 append_block(
   pico_feed_t *feed,
@@ -515,17 +1282,52 @@ append_block(
   const ssize_t b_size = pf_sizeof(body_len, headers, nheaders);
   if (b_size < 0) return b_size;
 
-  if ((size_t)b_size > feed->capacity - feed->tail) {
-    grow(feed, feed->tail + (size_t)b_size);
-  }
+  int err = reserve_block(feed, (size_t)b_size);
+  if (err) return err;
 
-  int err = pf_create_block(&feed->buffer[feed->tail], body, body_len, headers, nheaders, pair);
+  err = pf_create_block(&feed->buffer[feed->tail], body, body_len, headers, nheaders, pair);
   if (err != b_size) return err;
 
-  feed->tail += b_size;
+  commit_block(feed, (size_t)b_size);
   return pf_len(feed);
 }
 
+/* copies id of the last block without verifying the feed
+ * @return feed length */
+static int
+tip_id(const pico_feed_t *feed, pf_signature_t id) {
+  size_t offset = feed_head(feed);
+  size_t last = 0;
+  int len = 0;
+
+  while (offset < feed->tail) {
+    last = offset;
+    offset += (size_t)pf_next_block_offset(feed->buffer + offset);
+    ++len;
+  }
+  if (len) cpy(id, feed->buffer + last, sizeof(pf_signature_t));
+  return len;
+}
+
+/* copies the HDR_SKIP target of the next block
+ * @return 1 when linked, 0 when not needed, < 0 on error */
+static int
+skip_link(const pico_feed_t *feed, pf_signature_t target) {
+  pf_block_view_t genesis;
+  size_t offset = feed_head(feed);
+  const int idx = pf_len(feed);
+  const int skip = pf_skip_index(idx);
+
+  if (skip >= idx - 1) return 0;
+  if (pf_decode_view(feed->buffer + offset, &genesis, 1) < 0) return EFAILED;
+  /* sliced, shifted or capped, the target may be gone */
+  if (genesis.psig != NULL) return EBOUNDS;
+
+  for (int i = 0; i < skip; ++i) offset += (size_t)pf_next_block_offset(feed->buffer + offset);
+  cpy(target, feed->buffer + offset, sizeof(pf_signature_t));
+  return 1;
+}
+
 ssize_t
 pf_append(
   pico_feed_t *feed,
@@ -535,8 +1337,11 @@ pf_append(
   size_t nheaders,
   const pf_keypair_t pair
 ) {
-  pf_block_t last = {0};
+  pf_signature_t last;
+  pf_signature_t skip;
+  int has_last = 0;
   int has_psig = 0;
+  int has_skip = 0;
   size_t merged_len = 1;
   size_t i;
   size_t j;
@@ -546,10 +1351,19 @@ pf_append(
   for (i = 0; i < nheaders; ++i) {
     if (headers[i].id == HDR_AUTHOR) continue;
     if (headers[i].id == HDR_PSIG) has_psig = 1;
+    if (headers[i].id == HDR_SKIP) has_skip = 1;
     ++merged_len;
   }
 
-  if (!has_psig && 0 == pf_last(feed, &last)) ++merged_len;
+  if (!has_psig && 0 < tip_id(feed, last)) {
+    has_last = 1;
+    ++merged_len;
+  }
+  if (!has_skip && (feed->flags & PF_FLAG_SKIP_LINKS)) {
+    has_skip = skip_link(feed, skip);
+    if (has_skip < 0) return has_skip;
+    merged_len += (size_t)has_skip;
+  } else has_skip = 0;
 
   pf_header_t merged[merged_len];
   merged[0].id = HDR_AUTHOR;
@@ -561,9 +1375,15 @@ pf_append(
     merged[j++] = headers[i];
   }
 
-  if (!has_psig && last.block_size) {
+  if (has_last) {
     merged[j].id = HDR_PSIG;
-    merged[j].value = last.id;
+    merged[j].value = last;
+    ++j;
+  }
+
+  if (has_skip) {
+    merged[j].id = HDR_SKIP;
+    merged[j].value = skip;
     ++j;
   }
 
@@ -571,25 +1391,92 @@ pf_append(
   return append_block(feed, body, body_len, merged, merged_len, pair);
 }
 
-void
+ssize_t
+pf_append_many(
+  pico_feed_t *feed,
+  const uint8_t *const *bodies,
+  const size_t *lens,
+  int n,
+  pf_keypair_t pair
+) {
+  ensure_magic(feed);
+  if (n < 0 || (n && (bodies == NULL || lens == NULL))) return EFAILED;
+  for (int i = 0; i < n; ++i) {
+    if (bodies[i] == NULL || lens[i] == 0 || bodies[i][0] == 0) return EFAILED;
+  }
+
+  /* capped and skip-linked feeds need per-block bookkeeping */
+  if (feed->max_size || (feed->flags & PF_FLAG_SKIP_LINKS)) {
+    ssize_t height = pf_len(feed);
+    for (int i = 0; i < n; ++i) {
+      height = pf_append(feed, bodies[i], lens[i], NULL, 0, pair);
+      if (height < 0) return height;
+    }
+    return height;
+  }
+
+  pf_signature_t last;
+  const int len = tip_id(feed, last);
+  const size_t author_size = PF_HDR_PREFIX_SIZE + sizeof(pf_key_t);
+  const size_t psig_size = PF_HDR_PREFIX_SIZE + sizeof(pf_signature_t);
+  size_t total = 0;
+
+  ensure_pair_pk(&pair);
+  for (int i = 0; i < n; ++i) {
+    const size_t data_size = author_size + (len || i ? psig_size : 0) + lens[i];
+    uint8_t varint[10];
+    total += sizeof(pf_signature_t) + (size_t)varint_encode(varint, data_size) + data_size;
+  }
+
+  int err = reserve_block(feed, total);
+  if (err) return err;
+
+  pf_header_t headers[2] = {
+    { .id = HDR_AUTHOR },
+    { .id = HDR_PSIG, .value = last }
+  };
+  for (int i = 0; i < n; ++i) {
+    uint8_t *dst = feed->buffer + feed->tail;
+    const size_t nheaders = len || i ? 2 : 1;
+    ssize_t o = encode_prefix(dst, lens[i], headers, nheaders, &pair);
+    assert(o > 0);
+
+    cpy(dst + o, bodies[i], lens[i]);
+    const size_t size = (size_t)o + lens[i];
+    pico_crypto_sign(dst, dst + sizeof(pf_signature_t), size - sizeof(pf_signature_t), pair);
+    commit_block(feed, size);
+
+    /* chain from the block just written, the buffer is not moved */
+    headers[1].value = dst;
+  }
+
+  return len + n;
+}
+
+int
 pf_truncate(pico_feed_t *feed, int height) {
   ensure_magic(feed);
+  if (feed->flags & PF_FLAG_MAPPED) return EFAILED;
 
   int len = pf_len(feed);
   if (height < 0) height = len + height;
   if (height <= 0) {
     feed->tail = PICOFEED_MAGIC_SIZE;
+    feed->head = PICOFEED_MAGIC_SIZE;
     zro(feed->reserved, sizeof(feed->reserved));
-    return;
+    digests_truncate(feed, 0, feed->tail);
+    return 0;
   }
-  if (height >= len) return;
+  if (height >= len) return 0;
 
-  ssize_t offset = PICOFEED_MAGIC_SIZE;
+  const int new_len = height;
+  ssize_t offset = feed_head(feed);
   while (offset < (ssize_t)feed->tail) {
     if (!height--) {
       feed->tail = offset;
       zro(feed->reserved, sizeof(feed->reserved));
-      return;
+      digests_truncate(feed, new_len, feed->tail);
+      return 0;
     }
 
     int n = pf_next_block_offset(&feed->buffer[offset]);
@@ -598,6 +1485,7 @@ pf_truncate(pico_feed_t *feed, int height) {
   }
 
   assert(0);
+  return EFAILED;
 }
 
 void
@@ -605,13 +1493,71 @@ pf_clone(pico_feed_t *dst, const pico_feed_t *src) {
   ensure_magic(src);
   assert(dst->buffer == NULL);
 
-  dst->tail = src->tail;
-  dst->capacity = src->tail;
-  dst->flags = src->flags;
-  dst->buffer = ualloc(dst->capacity);
-  assert(dst->buffer != NULL);
-  cpy(dst->buffer, src->buffer, dst->tail);
+  const size_t head = feed_head(src);
+  const size_t delta = head - PICOFEED_MAGIC_SIZE;
+
+  dst->tail = src->tail - delta;
+  dst->head = PICOFEED_MAGIC_SIZE;
+  dst->max_size = src->max_size;
+  dst->flags = src->flags & ~PF_FLAG_MAPPED;
+  dst->block_hint = src->block_hint;
+  dst->digests = NULL;
+
+  if (dst->tail <= PICOFEED_INLINE_CAPACITY) {
+    dst->capacity = PICOFEED_INLINE_CAPACITY;
+    dst->buffer = dst->inline_buffer;
+  } else {
+    /* same headroom as a buffer that just filled up */
+    dst->capacity = grow_capacity(dst->tail, dst->tail, src->block_hint);
+    dst->buffer = ualloc(dst->capacity);
+    assert(dst->buffer != NULL);
+  }
+  cpy(dst->buffer, PiC0, PICOFEED_MAGIC_SIZE);
+  cpy(dst->buffer + PICOFEED_MAGIC_SIZE, src->buffer + head, src->tail - head);
   cpy(dst->reserved, src->reserved, sizeof(dst->reserved));
+
+  if (src->digests != NULL && src->digests->tail >= head) {
+    const size_t size = sizeof(*src->digests) + src->digests->capacity * PICOFEED_DIGEST_SIZE;
+    dst->digests = ualloc(size);
+    assert(dst->digests != NULL);
+    cpy(dst->digests, src->digests, size);
+    dst->digests->tail -= delta;
+  }
+}
+
+int
+pf_shift(pico_feed_t *feed, int n) {
+  ensure_magic(feed);
+
+  size_t head = feed_head(feed);
+  int dropped = 0;
+
+  while (dropped < n && head < feed->tail) {
+    ssize_t size = pf_next_block_offset(&feed->buffer[head]);
+    assert(size > 0);
+    head += (size_t)size;
+    ++dropped;
+  }
+  if (!dropped) return 0;
+
+  if (head == feed->tail) head = feed->tail = PICOFEED_MAGIC_SIZE;
+  feed->head = head;
+  zro(feed->reserved, sizeof(feed->reserved));
+  if (feed->digests != NULL) {
+    feed->digests->height = 0;
+    feed->digests->tail = head;
+  }
+
+  if (head - PICOFEED_MAGIC_SIZE >= feed->capacity / 2) compact(feed);
+  return dropped;
+}
+
+void
+pf_set_max_size(pico_feed_t *feed, size_t max_size) {
+  ensure_magic(feed);
+  feed->max_size = max_size;
+  if (!max_size) return;
+  while (feed->tail - feed_head(feed) > max_size) pf_shift(feed, 1);
 }
 
 static int
@@ -624,7 +1570,7 @@ normalize_index(int idx, int len) {
 
 static size_t
 block_offset_at(const pico_feed_t *feed, int idx) {
-  size_t offset = PICOFEED_MAGIC_SIZE;
+  size_t offset = feed_head(feed);
 
   for (int i = 0; i < idx && offset < feed->tail; ++i) {
     int n = pf_next_block_offset(&feed->buffer[offset]);
@@ -640,6 +1586,7 @@ pf_slice(pico_feed_t *dst, const pico_feed_t *src, int start_idx, int end_idx) {
   ensure_magic(src);
   if (dst->buffer == NULL) pf_init(dst);
   else ensure_magic(dst);
+  if (dst->flags & PF_FLAG_MAPPED) return EFAILED;
 
   int src_len = pf_len(src);
   start_idx = normalize_index(start_idx, src_len);
@@ -653,7 +1600,7 @@ pf_slice(pico_feed_t *dst, const pico_feed_t *src, int start_idx, int end_idx) {
   pf_truncate(dst, 0);
   if (!len) return 0;
 
-  if (dst->capacity < PICOFEED_MAGIC_SIZE + len) grow(dst, PICOFEED_MAGIC_SIZE + len);
+  if (dst->capacity < PICOFEED_MAGIC_SIZE + len && grow(dst, PICOFEED_MAGIC_SIZE + len)) return EFAILED;
   cpy(dst->buffer, PiC0, PICOFEED_MAGIC_SIZE);
   cpy(dst->buffer + PICOFEED_MAGIC_SIZE, src->buffer + start, len);
   dst->tail = PICOFEED_MAGIC_SIZE + len;
@@ -709,7 +1656,2255 @@ pf_diff(const pico_feed_t *a, const pico_feed_t *b, int *out) {
 #undef yield
 }
 
+typedef struct {
+  int len;
+  size_t mask;
+  size_t *offsets; /* block offsets by index */
+  int *slots;      /* id hash -> index + 1 */
+} id_index_t;
+
+static inline size_t
+id_hash(const uint8_t *id) {
+  uint64_t h;
+  cpy(&h, id, sizeof(h));
+  return (size_t)(h * 0x9E3779B97F4A7C15ULL);
+}
+
+static int
+id_index_lookup(const id_index_t *index, const uint8_t *buffer, const uint8_t *id) {
+  for (size_t i = id_hash(id) & index->mask; index->slots[i]; i = (i + 1) & index->mask) {
+    int idx = index->slots[i] - 1;
+    if (0 == cmp(buffer + index->offsets[idx], id, sizeof(pf_signature_t))) return idx;
+  }
+  return -1;
+}
+
+static int
+id_index_build(id_index_t *index, const pico_feed_t *feed) {
+  pf_iterator_t iter = {0};
+  pf_block_view_t view;
+  size_t capacity = 16;
+  int err;
+
+  index->len = pf_len(feed);
+  while (capacity < (size_t)index->len * 2) capacity *= 2;
+  index->mask = capacity - 1;
+  index->offsets = ualloc(((size_t)index->len + 1) * sizeof(size_t));
+  index->slots = salloc(capacity, sizeof(int));
+  if (index->offsets == NULL || index->slots == NULL) return EFAILED;
+
+  while (0 == (err = pf_next_view(feed, &iter, &view))) {
+    size_t i = id_hash(view.id) & index->mask;
+    while (index->slots[i]) i = (i + 1) & index->mask;
+    index->slots[i] = iter.idx + 1;
+    index->offsets[iter.idx] = (size_t)(view.id - feed->buffer);
+  }
+  return err < 0 ? err : 0;
+}
+
+static pf_diff_result_t
+diff_indexed(const pico_feed_t *a, const id_index_t *index, const pico_feed_t *b) {
+#define yield(x) do { res.diff = (x); return res; } while (0)
+  pf_diff_result_t res = { OK, 0 };
+  const int len_a = index->len;
+  const int len_b = pf_len(b);
+  const uint8_t *psig_a, *psig_b;
+  pf_iterator_t it_b = {0};
+  pf_block_view_t head_a, view;
+  int i;
+
+  if (a == b) yield(0);
+  if (!len_a) yield(len_b);
+  if (!len_b) yield(-len_a);
+
+  if ((res.status = pf_next_view(b, &it_b, &view))) return res;
+  psig_b = view.psig != NULL ? view.psig : PF_ZERO_SIG;
+
+  pf_decode_view(a->buffer + index->offsets[0], &head_a, 1);
+  psig_a = head_a.psig != NULL ? head_a.psig : PF_ZERO_SIG;
+
+  /* same alignment rules as pf_diff() */
+  if (0 == cmp(psig_a, psig_b, sizeof(pf_signature_t))) i = 0;
+  else if ((i = id_index_lookup(index, a->buffer, psig_b)) >= 0) {
+    if (i == len_a - 1) yield(len_b);
+    ++i;
+  } else {
+    res.status = UNRELATED;
+    return res;
+  }
+
+  while (1) {
+    if (0 != cmp(a->buffer + index->offsets[i], view.id, sizeof(pf_signature_t))) {
+      res.status = DIVERGED;
+      return res;
+    }
+    if (!(i < len_a - 1 && it_b.idx < len_b - 1)) break;
+    ++i;
+    if ((res.status = pf_next_view(b, &it_b, &view))) return res;
+  }
+
+  if (i == len_a - 1 && it_b.idx == len_b - 1) yield(0);
+  else if (i == len_a - 1) yield(len_b - it_b.idx - 1);
+  else yield(i + 1 - len_a);
+#undef yield
+}
+
+int
+pf_diff_many(const pico_feed_t *local, const pico_feed_t *const *remotes, int n, pf_diff_result_t *out) {
+  id_index_t index = {0};
+  int err = id_index_build(&index, local);
+
+  for (int r = 0; !err && r < n; ++r) out[r] = diff_indexed(local, &index, remotes[r]);
+
+  free(index.offsets);
+  free(index.slots);
+  return err;
+}
+
+/* --------------- Watermark ---------------*/
+
+static inline void
+u64_encode(uint8_t *dst, uint64_t value) {
+  for (int i = 0; i < 8; ++i) dst[i] = (uint8_t)(value >> (i * 8));
+}
+
+static inline uint64_t
+u64_decode(const uint8_t *src) {
+  uint64_t value = 0;
+  for (int i = 0; i < 8; ++i) value |= (uint64_t)src[i] << (i * 8);
+  return value;
+}
+
+/* covers `size` bytes from the feed head, stable across compaction */
+static void
+watermark_checksum(uint8_t checksum[32], const pico_feed_t *feed, size_t size, const uint8_t key[32]) {
+  pico_crypto_hash(checksum, 32, key, key == NULL ? 0 : 32, feed->buffer + feed_head(feed), size);
+}
+
+int
+pf_watermark(const pico_feed_t *feed, pf_watermark_t *wm, const uint8_t key[32]) {
+  ensure_magic(feed);
+
+  zro(wm, sizeof(*wm));
+  wm->height = tip_id(feed, wm->tip);
+  wm->size = feed->tail - feed_head(feed);
+  watermark_checksum(wm->checksum, feed, wm->size, key);
+  return 0;
+}
+
+int
+pf_watermark_save(const pf_watermark_t *wm, const char *path) {
+  uint8_t buffer[PICOFEED_WATERMARK_SIZE];
+  size_t o = 0;
+
+  cpy(buffer, PICOFEED_WATERMARK_MAGIC, PICOFEED_MAGIC_SIZE);
+  o += PICOFEED_MAGIC_SIZE;
+  u64_encode(buffer + o, wm->height);
+  o += 8;
+  u64_encode(buffer + o, wm->size);
+  o += 8;
+  cpy(buffer + o, wm->tip, sizeof(wm->tip));
+  o += sizeof(wm->tip);
+  cpy(buffer + o, wm->checksum, sizeof(wm->checksum));
+  o += sizeof(wm->checksum);
+  assert(o == sizeof(buffer));
+
+  /* replace atomically so a crash never leaves a torn watermark */
+  char tmp[4096];
+  if (snprintf(tmp, sizeof(tmp), "%s.tmp", path) >= (int)sizeof(tmp)) return EFAILED;
+  int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) return EFAILED;
+  int err = sizeof(buffer) == write(fd, buffer, sizeof(buffer)) && 0 == fsync(fd) ? 0 : EFAILED;
+  if (0 != close(fd)) err = EFAILED;
+  if (!err && 0 != rename(tmp, path)) err = EFAILED;
+  if (err) unlink(tmp);
+  return err;
+}
+
+int
+pf_watermark_load(pf_watermark_t *wm, const char *path) {
+  uint8_t buffer[PICOFEED_WATERMARK_SIZE];
+  size_t o = PICOFEED_MAGIC_SIZE;
+
+  FILE *file = fopen(path, "rb");
+  if (file == NULL) return EFAILED;
+  size_t n = fread(buffer, 1, sizeof(buffer), file);
+  fclose(file);
+  if (n != sizeof(buffer)) return EFAILED;
+  if (0 != cmp(buffer, PICOFEED_WATERMARK_MAGIC, PICOFEED_MAGIC_SIZE)) return EFAILED;
+
+  wm->height = u64_decode(buffer + o);
+  o += 8;
+  wm->size = u64_decode(buffer + o);
+  o += 8;
+  cpy(wm->tip, buffer + o, sizeof(wm->tip));
+  o += sizeof(wm->tip);
+  cpy(wm->checksum, buffer + o, sizeof(wm->checksum));
+  return 0;
+}
+
+int
+pf_verify_watermark(const pico_feed_t *feed, const pf_watermark_t *wm, const uint8_t key[32]) {
+  uint8_t checksum[32];
+  ensure_magic(feed);
+
+  if (wm->size > feed->tail - feed_head(feed)) return EBOUNDS;
+  if (wm->height > (uint64_t)(wm->size / sizeof(pf_signature_t))) return EBOUNDS;
+
+  watermark_checksum(checksum, feed, wm->size, key);
+  if (0 != cmp(checksum, wm->checksum, sizeof(checksum))) return EVERFAIL;
+  return verify_from(feed, (int)wm->height, wm->tip, NULL); /* prefix bound by the checksum */
+}
+
+/* --------------- Verify Pool ---------------*/
+
+#ifdef PICO_EXTERN_CRYPTO
+/* batch items of the built-in backends, verified one by one here */
+typedef struct {
+  const uint8_t *signature;
+  const uint8_t *message;
+  size_t message_len;
+  const uint8_t *pk;
+} pf_verify_item_t;
+#endif
+
+typedef struct {
+  const pico_feed_t *feed;
+  pf_verify_cb cb;
+  void *ctx;
+  int height;
+  atomic_int pending;
+  pthread_mutex_t lock;
+  int err;
+  int err_idx;
+} verify_job_t;
+
+typedef struct {
+  verify_job_t *job;
+  size_t prev;
+  size_t start;
+  size_t end;
+  int idx;
+} verify_task_t;
+
+typedef struct {
+  pthread_mutex_t lock;
+  verify_task_t *tasks;
+  size_t head;
+  size_t len;
+  size_t capacity;
+} verify_deque_t;
+
+struct pf_verify_pool_s {
+  int nthreads;
+  pthread_t *threads;
+  verify_deque_t *deques;
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  pthread_cond_t done;
+  atomic_size_t queued;
+  size_t jobs;
+  unsigned next;
+  int stop;
+};
+
+typedef struct {
+  pf_verify_pool_t *pool;
+  int id;
+} verify_worker_t;
+
+static void
+deque_push(verify_deque_t *dq, const verify_task_t *tasks, size_t n) {
+  pthread_mutex_lock(&dq->lock);
+  if (dq->len + n > dq->capacity) {
+    size_t capacity = dq->capacity ? dq->capacity : 64;
+    while (capacity < dq->len + n) capacity <<= 1;
+    verify_task_t *ring = ualloc(capacity * sizeof(verify_task_t));
+    assert(ring != NULL);
+    for (size_t i = 0; i < dq->len; ++i) ring[i] = dq->tasks[(dq->head + i) % dq->capacity];
+    free(dq->tasks);
+    dq->tasks = ring;
+    dq->head = 0;
+    dq->capacity = capacity;
+  }
+  for (size_t i = 0; i < n; ++i) dq->tasks[(dq->head + dq->len++) % dq->capacity] = tasks[i];
+  pthread_mutex_unlock(&dq->lock);
+}
+
+/* owner pops newest, thieves steal oldest */
+static int
+deque_pop(verify_deque_t *dq, verify_task_t *task, int steal) {
+  int found = 0;
+  pthread_mutex_lock(&dq->lock);
+  if (dq->len) {
+    if (steal) {
+      *task = dq->tasks[dq->head];
+      dq->head = (dq->head + 1) % dq->capacity;
+    } else {
+      *task = dq->tasks[(dq->head + dq->len - 1) % dq->capacity];
+    }
+    dq->len--;
+    found = 1;
+  }
+  pthread_mutex_unlock(&dq->lock);
+  return found;
+}
+
+/* @return index of the first invalid signature or n */
+static int
+verify_items(const pf_verify_item_t *items, int n) {
+  if (n == 0) return 0;
+#ifdef PICO_EXTERN_CRYPTO
+  for (int i = 0; i < n; ++i) {
+    if (pico_crypto_verify(items[i].signature, items[i].message, items[i].message_len, items[i].pk)) return i;
+  }
+#else
+  int results[PICOFEED_VERIFY_BATCH];
+  if (0 == pico_crypto_verify_batch(items, n, results)) return n;
+  for (int i = 0; i < n; ++i) if (results[i]) return i;
+#endif
+  return n;
+}
+
+/* checks structure and linkage first,
+ * then hands all signatures of the range to the backend at once */
+static int
+verify_range(const pico_feed_t *feed, const verify_task_t *task, int *err_idx) {
+  pf_verify_item_t items[PICOFEED_VERIFY_BATCH];
+  size_t prev = task->prev;
+  size_t offset = task->start;
+  int nitems = 0;
+  int err = 0;
+
+  while (offset < task->end) {
+    pf_block_view_t view;
+    int n = pf_decode_view(&feed->buffer[offset], &view, 1);
+    if (n < 0) err = n;
+    else if (offset + (size_t)n > task->end) err = EFAILED;
+    else if (view.author == NULL) err = EVERFAIL;
+    else if (prev && (view.psig == NULL || 0 != cmp(view.psig, &feed->buffer[prev], sizeof(pf_signature_t)))) err = EPARENT;
+    if (err) break;
+
+    assert(nitems < PICOFEED_VERIFY_BATCH);
+    items[nitems].signature = view.id;
+    items[nitems].message = view.id + sizeof(pf_signature_t);
+    items[nitems].message_len = view.block_size - sizeof(pf_signature_t);
+    items[nitems].pk = view.author;
+    ++nitems;
+
+    prev = offset;
+    offset += (size_t)n;
+  }
+
+  const int invalid = verify_items(items, nitems);
+  *err_idx = task->idx + invalid;
+  if (invalid < nitems) return EVERFAIL;
+  return err;
+}
+
+static void
+job_finish(pf_verify_pool_t *pool, verify_job_t *job) {
+  job->cb(job->feed, job->err ? job->err : job->height, job->ctx);
+  pthread_mutex_destroy(&job->lock);
+  free(job);
+
+  pthread_mutex_lock(&pool->lock);
+  if (0 == --pool->jobs) pthread_cond_broadcast(&pool->done);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+static void
+run_task(pf_verify_pool_t *pool, const verify_task_t *task) {
+  verify_job_t *job = task->job;
+  int idx = 0;
+  int err = verify_range(job->feed, task, &idx);
+
+  if (err) {
+    pthread_mutex_lock(&job->lock);
+    if (!job->err || idx < job->err_idx) {
+      job->err = err;
+      job->err_idx = idx;
+    }
+    pthread_mutex_unlock(&job->lock);
+  }
+
+  if (1 == atomic_fetch_sub(&job->pending, 1)) job_finish(pool, job);
+}
+
+static int
+next_task(pf_verify_pool_t *pool, int id, verify_task_t *task) {
+  if (deque_pop(&pool->deques[id], task, 0)) return 1;
+  for (int i = 1; i < pool->nthreads; ++i) {
+    if (deque_pop(&pool->deques[(id + i) % pool->nthreads], task, 1)) return 1;
+  }
+  return 0;
+}
+
+static void *
+verify_worker(void *arg) {
+  verify_worker_t *worker = arg;
+  pf_verify_pool_t *pool = worker->pool;
+  const int id = worker->id;
+  verify_task_t task;
+  free(worker);
+
+  while (1) {
+    if (next_task(pool, id, &task)) {
+      atomic_fetch_sub(&pool->queued, 1);
+      run_task(pool, &task);
+      continue;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    while (!pool->stop && 0 == atomic_load(&pool->queued)) pthread_cond_wait(&pool->wake, &pool->lock);
+    const int stop = pool->stop && 0 == atomic_load(&pool->queued);
+    pthread_mutex_unlock(&pool->lock);
+    if (stop) break;
+  }
+  return NULL;
+}
+
+pf_verify_pool_t *
+pf_verify_pool_create(int nthreads) {
+  if (nthreads <= 0) nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (nthreads <= 0) nthreads = 1;
+
+  pf_verify_pool_t *pool = salloc(1, sizeof(*pool));
+  if (pool == NULL) return NULL;
+  pool->nthreads = nthreads;
+  pool->threads = salloc(nthreads, sizeof(pthread_t));
+  pool->deques = salloc(nthreads, sizeof(verify_deque_t));
+  assert(pool->threads != NULL && pool->deques != NULL);
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->wake, NULL);
+  pthread_cond_init(&pool->done, NULL);
+  atomic_init(&pool->queued, 0);
+
+  for (int i = 0; i < nthreads; ++i) pthread_mutex_init(&pool->deques[i].lock, NULL);
+  for (int i = 0; i < nthreads; ++i) {
+    verify_worker_t *worker = ualloc(sizeof(*worker));
+    assert(worker != NULL);
+    worker->pool = pool;
+    worker->id = i;
+    error_check(pthread_create(&pool->threads[i], NULL, verify_worker, worker));
+  }
+
+  return pool;
+}
+
+int
+pf_verify_pool_submit(pf_verify_pool_t *pool, const pico_feed_t *feed, pf_verify_cb cb, void *ctx) {
+  ensure_magic(feed);
+  if (cb == NULL) return EFAILED;
+
+  verify_job_t *job = salloc(1, sizeof(*job));
+  if (job == NULL) return EFAILED;
+  job->feed = feed;
+  job->cb = cb;
+  job->ctx = ctx;
+  pthread_mutex_init(&job->lock, NULL);
+
+  /* split feed into batches, only block sizes are read here */
+  size_t ntasks = 0;
+  size_t capacity = 8;
+  verify_task_t *tasks = ualloc(capacity * sizeof(verify_task_t));
+  size_t prev = 0;
+  size_t offset = feed_head(feed);
+  assert(tasks != NULL);
+
+  /* empty feeds get one empty task so cb still runs on a worker */
+  do {
+    verify_task_t *task;
+    if (ntasks == capacity) {
+      capacity <<= 1;
+      tasks = ralloc(tasks, capacity * sizeof(verify_task_t));
+      assert(tasks != NULL);
+    }
+    task = &tasks[ntasks++];
+    task->job = job;
+    task->prev = prev;
+    task->start = offset;
+    task->idx = job->height;
+
+    for (int i = 0; i < PICOFEED_VERIFY_BATCH && offset < feed->tail; ++i) {
+      ssize_t n = pf_next_block_offset(&feed->buffer[offset]);
+      if (n <= 0 || offset + (size_t)n > feed->tail) {
+        job->err = EFAILED;
+        job->err_idx = job->height;
+        offset = feed->tail;
+        break;
+      }
+      prev = offset;
+      offset += (size_t)n;
+      ++job->height;
+    }
+    task->end = offset;
+  } while (offset < feed->tail);
+  atomic_init(&job->pending, (int)ntasks);
+
+  pthread_mutex_lock(&pool->lock);
+  pool->jobs++;
+  const unsigned owner = pool->next++ % (unsigned)pool->nthreads;
+  /* counted before the push, a worker may pop a task right away */
+  atomic_fetch_add(&pool->queued, ntasks);
+  pthread_mutex_unlock(&pool->lock);
+
+  deque_push(&pool->deques[owner], tasks, ntasks);
+  free(tasks);
+
+  pthread_mutex_lock(&pool->lock);
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+  return 0;
+}
+
+void
+pf_verify_pool_wait(pf_verify_pool_t *pool) {
+  pthread_mutex_lock(&pool->lock);
+  while (pool->jobs) pthread_cond_wait(&pool->done, &pool->lock);
+  pthread_mutex_unlock(&pool->lock);
+}
+
+void
+pf_verify_pool_destroy(pf_verify_pool_t *pool) {
+  if (pool == NULL) return;
+  pf_verify_pool_wait(pool);
+
+  pthread_mutex_lock(&pool->lock);
+  pool->stop = 1;
+  pthread_cond_broadcast(&pool->wake);
+  pthread_mutex_unlock(&pool->lock);
+
+  for (int i = 0; i < pool->nthreads; ++i) pthread_join(pool->threads[i], NULL);
+  for (int i = 0; i < pool->nthreads; ++i) {
+    pthread_mutex_destroy(&pool->deques[i].lock);
+    free(pool->deques[i].tasks);
+  }
+
+  pthread_cond_destroy(&pool->done);
+  pthread_cond_destroy(&pool->wake);
+  pthread_mutex_destroy(&pool->lock);
+  free(pool->deques);
+  free(pool->threads);
+  free(pool);
+}
+
+/* --------------- Ingest Pipeline ---------------*/
+
+enum {
+  SLOT_EMPTY = 0,
+  SLOT_QUEUED,
+  SLOT_VERIFIED,
+  SLOT_FAILED
+};
+
+typedef struct {
+  uint8_t *bytes;
+  size_t size;
+  int state;
+  int err;
+} ingest_slot_t;
+
+struct pf_ingest_s {
+  pico_feed_t *dst;
+  int nthreads;
+  pthread_t *verifiers;
+  pthread_t committer;
+  pthread_mutex_t lock;
+  pthread_cond_t not_full;
+  pthread_cond_t work;
+  pthread_cond_t ready;
+  size_t depth;
+  ingest_slot_t *slots;
+  size_t next_parse;
+  size_t next_verify;
+  size_t next_commit;
+  uint8_t *stage;
+  size_t stage_len;
+  size_t stage_capacity;
+  pf_signature_t last_id;
+  int has_last;
+  int started;
+  int eof;
+  int err;
+  pf_ingest_stats_t stats;
+};
+
+static inline uint64_t
+now_ns(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000LLU + (uint64_t)ts.tv_nsec;
+}
+
+static void *
+ingest_verifier(void *arg) {
+  pf_ingest_t *ing = arg;
+
+  pthread_mutex_lock(&ing->lock);
+  while (1) {
+    while (!ing->eof && !ing->err && ing->next_verify == ing->next_parse) pthread_cond_wait(&ing->work, &ing->lock);
+    if (ing->next_verify == ing->next_parse) break;
+
+    ingest_slot_t *slot = &ing->slots[ing->next_verify++ % ing->depth];
+    const int failed = ing->err;
+    pthread_mutex_unlock(&ing->lock);
+
+    pf_block_t block;
+    const uint64_t start = now_ns();
+    int n = failed ? EFAILED : pf_decode_block(slot->bytes, &block, 0);
+    const uint64_t elapsed = now_ns() - start;
+
+    pthread_mutex_lock(&ing->lock);
+    ing->stats.verify_ns += elapsed;
+    if (n == (int)slot->size) {
+      slot->state = SLOT_VERIFIED;
+      ing->stats.blocks_verified++;
+    } else {
+      slot->state = SLOT_FAILED;
+      slot->err = n < 0 ? n : EFAILED;
+    }
+    pthread_cond_broadcast(&ing->ready);
+  }
+  pthread_mutex_unlock(&ing->lock);
+  return NULL;
+}
+
+static int
+ingest_commit(pf_ingest_t *ing, const ingest_slot_t *slot) {
+  pico_feed_t *dst = ing->dst;
+  pf_block_t block;
+
+  if (slot->state == SLOT_FAILED) return slot->err;
+  pf_decode_block(slot->bytes, &block, 1);
+
+  if (ing->has_last) {
+    const pf_signature_t *psig = pf_block_header(&block, HDR_PSIG);
+    if (psig == NULL || 0 != cmp(*psig, ing->last_id, sizeof(pf_signature_t))) return EPARENT;
+  }
+
+  int err = reserve_block(dst, slot->size);
+  if (err) return err;
+  cpy(&dst->buffer[dst->tail], slot->bytes, slot->size);
+  commit_block(dst, slot->size);
+
+  cpy(ing->last_id, slot->bytes, sizeof(pf_signature_t));
+  ing->has_last = 1;
+  return 0;
+}
+
+static void *
+ingest_committer(void *arg) {
+  pf_ingest_t *ing = arg;
+
+  pthread_mutex_lock(&ing->lock);
+  while (1) {
+    ingest_slot_t *slot = &ing->slots[ing->next_commit % ing->depth];
+    while (ing->next_commit < ing->next_parse && (slot->state == SLOT_QUEUED)) pthread_cond_wait(&ing->ready, &ing->lock);
+    if (ing->next_commit == ing->next_parse) {
+      if (ing->eof) break;
+      pthread_cond_wait(&ing->ready, &ing->lock);
+      continue;
+    }
+    const int failed = ing->err;
+    pthread_mutex_unlock(&ing->lock);
+
+    const uint64_t start = now_ns();
+    int err = failed ? failed : ingest_commit(ing, slot);
+    const uint64_t elapsed = now_ns() - start;
+    free(slot->bytes);
+
+    pthread_mutex_lock(&ing->lock);
+    zro(slot, sizeof(*slot));
+    ing->stats.commit_ns += elapsed;
+    if (err && !ing->err) ing->err = err;
+    if (!err) ing->stats.blocks_committed++;
+    ing->next_commit++;
+    pthread_cond_broadcast(&ing->not_full);
+    if (ing->err) pthread_cond_broadcast(&ing->work);
+  }
+  pthread_mutex_unlock(&ing->lock);
+  return NULL;
+}
+
+/* @return bytes consumed, blocks until pipeline has room */
+static ssize_t
+ingest_parse(pf_ingest_t *ing, const uint8_t *buffer, size_t len) {
+  size_t o = 0;
+
+  if (!ing->started) {
+    if (len < PICOFEED_MAGIC_SIZE) return 0;
+    if (0 == cmp(buffer, PiC0, PICOFEED_MAGIC_SIZE)) o += PICOFEED_MAGIC_SIZE;
+    ing->started = 1;
+  }
+
+  while (len - o > sizeof(pf_signature_t)) {
+    const uint8_t *bytes = buffer + o;
+    size_t avail = len - o - sizeof(pf_signature_t);
+    size_t vo = 0;
+    while (vo < avail && vo < sizeof(size_t) && bytes[sizeof(pf_signature_t) + vo] & 0x80) ++vo;
+    if (vo == sizeof(size_t)) return EFAILED;
+    if (vo == avail) break;
+
+    ssize_t size = pf_next_block_offset(bytes);
+    if (size <= 0) return EFAILED;
+    /* refuse before buffering, a peer could claim any size */
+    if ((size_t)size > (ing->dst->max_size ? ing->dst->max_size : PICOFEED_MAX_BLOCK)) return EBOUNDS;
+    if ((size_t)size > len - o) break;
+
+    uint8_t *copy = ualloc((size_t)size);
+    if (copy == NULL) return EFAILED;
+    cpy(copy, bytes, (size_t)size);
+
+    pthread_mutex_lock(&ing->lock);
+    while (!ing->err && ing->next_parse - ing->next_commit == ing->depth) {
+      ing->stats.read_stalls++;
+      pthread_cond_wait(&ing->not_full, &ing->lock);
+    }
+    if (ing->err) {
+      pthread_mutex_unlock(&ing->lock);
+      free(copy);
+      return ing->err;
+    }
+    ingest_slot_t *slot = &ing->slots[ing->next_parse++ % ing->depth];
+    slot->bytes = copy;
+    slot->size = (size_t)size;
+    slot->state = SLOT_QUEUED;
+    ing->stats.blocks_read++;
+    pthread_cond_signal(&ing->work);
+    pthread_mutex_unlock(&ing->lock);
+
+    o += (size_t)size;
+  }
+
+  return (ssize_t)o;
+}
+
+pf_ingest_t *
+pf_ingest_create(pico_feed_t *dst, int nthreads, size_t depth) {
+  ensure_magic(dst);
+  if (nthreads <= 0) nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (nthreads <= 0) nthreads = 1;
+  if (!depth) depth = PICOFEED_INGEST_DEPTH;
+
+  pf_ingest_t *ing = salloc(1, sizeof(*ing));
+  if (ing == NULL) return NULL;
+  ing->dst = dst;
+  ing->nthreads = nthreads;
+  ing->depth = depth;
+  ing->slots = salloc(depth, sizeof(ingest_slot_t));
+  ing->verifiers = salloc(nthreads, sizeof(pthread_t));
+  assert(ing->slots != NULL && ing->verifiers != NULL);
+
+  const int len = pf_len(dst);
+  if (len) {
+    cpy(ing->last_id, &dst->buffer[block_offset_at(dst, len - 1)], sizeof(pf_signature_t));
+    ing->has_last = 1;
+  }
+
+  pthread_mutex_init(&ing->lock, NULL);
+  pthread_cond_init(&ing->not_full, NULL);
+  pthread_cond_init(&ing->work, NULL);
+  pthread_cond_init(&ing->ready, NULL);
+  for (int i = 0; i < nthreads; ++i) {
+    error_check(pthread_create(&ing->verifiers[i], NULL, ingest_verifier, ing));
+  }
+  error_check(pthread_create(&ing->committer, NULL, ingest_committer, ing));
+  return ing;
+}
+
+static int
+ingest_fail(pf_ingest_t *ing, int err) {
+  pthread_mutex_lock(&ing->lock);
+  if (!ing->err) ing->err = err;
+  err = ing->err;
+  pthread_cond_broadcast(&ing->work);
+  pthread_mutex_unlock(&ing->lock);
+  return err;
+}
+
+int
+pf_ingest_write(pf_ingest_t *ing, const uint8_t *bytes, size_t len) {
+  ssize_t n;
+  if (ing->eof) return EFAILED;
+
+  pthread_mutex_lock(&ing->lock);
+  ing->stats.bytes_read += len;
+  pthread_mutex_unlock(&ing->lock);
+
+  if (!ing->stage_len) {
+    n = ingest_parse(ing, bytes, len);
+    if (n < 0) return ingest_fail(ing, (int)n);
+    bytes += n;
+    len -= (size_t)n;
+    if (!len) return 0;
+  }
+
+  if (ing->stage_len + len > ing->stage_capacity) {
+    size_t capacity = ing->stage_capacity ? ing->stage_capacity : 1024;
+    while (capacity < ing->stage_len + len) capacity <<= 1;
+    ing->stage = ralloc(ing->stage, capacity);
+    assert(ing->stage != NULL);
+    ing->stage_capacity = capacity;
+  }
+  cpy(ing->stage + ing->stage_len, bytes, len);
+  ing->stage_len += len;
+
+  n = ingest_parse(ing, ing->stage, ing->stage_len);
+  if (n < 0) return ingest_fail(ing, (int)n);
+  ing->stage_len -= (size_t)n;
+  if (n && ing->stage_len) mov(ing->stage, ing->stage + n, ing->stage_len);
+  return 0;
+}
+
+int
+pf_ingest_finish(pf_ingest_t *ing) {
+  if (!ing->eof) {
+    pthread_mutex_lock(&ing->lock);
+    ing->eof = 1;
+    if (ing->stage_len && !ing->err) ing->err = EFAILED;
+    pthread_cond_broadcast(&ing->work);
+    pthread_cond_broadcast(&ing->ready);
+    pthread_mutex_unlock(&ing->lock);
+
+    for (int i = 0; i < ing->nthreads; ++i) pthread_join(ing->verifiers[i], NULL);
+    pthread_join(ing->committer, NULL);
+  }
+
+  return ing->err ? ing->err : pf_len(ing->dst);
+}
+
+void
+pf_ingest_stats(pf_ingest_t *ing, pf_ingest_stats_t *stats) {
+  pthread_mutex_lock(&ing->lock);
+  *stats = ing->stats;
+  pthread_mutex_unlock(&ing->lock);
+}
+
+void
+pf_ingest_destroy(pf_ingest_t *ing) {
+  if (ing == NULL) return;
+  pf_ingest_finish(ing);
+
+  for (size_t i = 0; i < ing->depth; ++i) free(ing->slots[i].bytes);
+  pthread_cond_destroy(&ing->ready);
+  pthread_cond_destroy(&ing->work);
+  pthread_cond_destroy(&ing->not_full);
+  pthread_mutex_destroy(&ing->lock);
+  free(ing->stage);
+  free(ing->verifiers);
+  free(ing->slots);
+  free(ing);
+}
+
+/* --------------- Columnar Scan ---------------*/
+
+static const void *
+view_header(const pf_block_view_t *view, pf_header_id_t id) {
+  pf_header_iter_t iter;
+  if (id == HDR_AUTHOR) return view->author;
+  if (id == HDR_PSIG) return view->psig;
+
+  header_begin(&iter, view->id, view->body);
+  while (0 == pf_header_next(&iter)) {
+    if (iter.id == id) return iter.value;
+  }
+  return NULL;
+}
+
+int
+pf_decode_batch(const pico_feed_t *feed, size_t start, int count, pf_columns_t *cols) {
+  pf_block_view_t view;
+  size_t offset = start ? start : feed_head(feed);
+  int i = 0;
+
+  ensure_magic(feed);
+  if (count > PICOFEED_BATCH_SIZE) count = PICOFEED_BATCH_SIZE;
+  if (offset < feed_head(feed)) return EBOUNDS;
+
+  for (; i < count && offset < feed->tail; ++i) {
+    int n = pf_decode_view(feed->buffer + offset, &view, 1);
+    if (n < 0) return n;
+    if (offset + (size_t)n > feed->tail) return EFAILED;
+
+    cols->offset[i] = offset;
+    cols->body[i] = view.body;
+    cols->len[i] = view.len;
+    cols->author[i] = view.author;
+    cols->psig[i] = view.psig;
+    offset += (size_t)n;
+  }
+
+  if (cols->header) {
+    for (int j = 0; j < i; ++j) {
+      view.id = feed->buffer + cols->offset[j];
+      view.body = cols->body[j];
+      view.author = cols->author[j];
+      view.psig = cols->psig[j];
+      cols->value[j] = view_header(&view, cols->header);
+    }
+  }
+
+  cols->count = i;
+  cols->next = offset;
+  return i;
+}
+
+/* --------------- Predicate Scan ---------------*/
+
+typedef struct {
+  const pico_feed_t *feed;
+  const pf_query_t *query;
+  size_t start;
+  size_t end;
+  const uint8_t *prev; /* id preceding start, NULL when unknown */
+  size_t *hits;
+  int nhits;
+  int capacity;
+  int err;
+  pthread_t thread;
+} scan_range_t;
+
+static int
+body_contains(const uint8_t *body, size_t len, const uint8_t *pattern, size_t plen) {
+  if (plen == 0) return 1;
+  for (size_t o = 0; o + plen <= len;) {
+    const uint8_t *p = memchr(body + o, pattern[0], len - plen - o + 1);
+    if (p == NULL) return 0;
+    if (0 == cmp(p, pattern, plen)) return 1;
+    o = (size_t)(p - body) + 1;
+  }
+  return 0;
+}
+
+static int
+query_match(const pf_query_t *q, const pf_block_view_t *view) {
+  if (q->author != NULL && (view->author == NULL || 0 != cmp(view->author, q->author, sizeof(pf_key_t)))) return 0;
+  if (q->body_prefix_len > view->len) return 0;
+  if (q->body_prefix_len && 0 != cmp(view->body, q->body_prefix, q->body_prefix_len)) return 0;
+  if (!body_contains(view->body, view->len, q->pattern, q->pattern_len)) return 0;
+  if (q->header) {
+    const void *value = view_header(view, q->header);
+    if (value == NULL) return 0;
+    if (q->header_value != NULL && 0 != cmp(value, q->header_value, (size_t)pf_header_size(q->header))) return 0;
+  }
+  return 1;
+}
+
+static void *
+scan_range(void *arg) {
+  scan_range_t *r = arg;
+  const uint8_t *buffer = r->feed->buffer;
+  const uint8_t *prev = r->prev;
+  pf_block_view_t view;
+
+  for (size_t o = r->start; o < r->end;) {
+    int n = pf_decode_view(buffer + o, &view, 1);
+    if (n < 0) { r->err = n; break; }
+    if (prev != NULL && (view.psig == NULL || 0 != cmp(view.psig, prev, sizeof(pf_signature_t)))) {
+      r->err = EPARENT;
+      break;
+    }
+
+    if (query_match(r->query, &view)) {
+      if (view.author == NULL || 0 != pico_crypto_verify(
+        view.id,
+        view.id + sizeof(pf_signature_t),
+        view.block_size - sizeof(pf_signature_t),
+        view.author
+      )) { r->err = EVERFAIL; break; }
+
+      if (r->nhits == r->capacity) {
+        int capacity = r->capacity ? r->capacity * 2 : 64;
+        size_t *hits = ralloc(r->hits, (size_t)capacity * sizeof(size_t));
+        if (hits == NULL) { r->err = EFAILED; break; }
+        r->hits = hits;
+        r->capacity = capacity;
+      }
+      r->hits[r->nhits++] = o;
+    }
+
+    prev = view.id;
+    o += (size_t)n;
+  }
+  return NULL;
+}
+
+int
+pf_scan(
+  const pico_feed_t *feed,
+  const pf_query_t *query,
+  int nthreads,
+  size_t *matches,
+  int max_matches
+) {
+  ensure_magic(feed);
+  if (query == NULL) return EFAILED;
+  if (query->header && pf_header_size(query->header) < 0) return EUNKHDR;
+
+  int len = pf_len(feed);
+  if (nthreads < 1) nthreads = 1;
+  if (nthreads > len) nthreads = len > 0 ? len : 1;
+
+  scan_range_t *ranges = salloc((size_t)nthreads, sizeof(scan_range_t));
+  if (ranges == NULL) return EFAILED;
+
+  /* split by block count */
+  size_t offset = feed_head(feed);
+  const uint8_t *prev = NULL;
+  int r = 0;
+  for (int i = 0; i < len; ++i) {
+    if (r < nthreads && i == (int)((int64_t)r * len / nthreads)) {
+      ranges[r].start = offset;
+      ranges[r].prev = prev;
+      if (r > 0) ranges[r - 1].end = offset;
+      r++;
+    }
+    prev = feed->buffer + offset;
+    offset += (size_t)pf_next_block_offset(prev);
+  }
+  for (int i = 0; i < nthreads; ++i) {
+    ranges[i].feed = feed;
+    ranges[i].query = query;
+    if (i >= r) ranges[i].start = feed->tail;
+  }
+  ranges[nthreads - 1].end = feed->tail;
+
+  int spawned = 0;
+  for (; spawned < nthreads - 1; ++spawned) {
+    if (0 != pthread_create(&ranges[spawned].thread, NULL, scan_range, &ranges[spawned])) break;
+  }
+  /* ranges that could not get a thread run here */
+  for (int i = spawned; i < nthreads; ++i) scan_range(&ranges[i]);
+  for (int i = 0; i < spawned; ++i) pthread_join(ranges[i].thread, NULL);
+
+  int total = 0;
+  int err = 0;
+  for (int i = 0; i < nthreads; ++i) {
+    if (!err && ranges[i].err) err = ranges[i].err;
+    for (int j = 0; j < ranges[i].nhits; ++j, ++total) {
+      if (matches != NULL && total < max_matches) matches[total] = ranges[i].hits[j];
+    }
+    free(ranges[i].hits);
+  }
+  free(ranges);
+  return err ? err : total;
+}
+
+/* --------------- Fork Index ---------------*/
+
+typedef struct {
+  pf_key_t author;
+  pf_signature_t parent;
+  pf_signature_t child;
+  uint8_t used;
+} fork_entry_t;
+
+struct pf_fork_index_s {
+  size_t len;
+  size_t capacity; /* power of two */
+  fork_entry_t *entries;
+  uint8_t key[16];
+};
+
+/* authors pick their signatures, keyed so they cannot aim for one bucket */
+static inline size_t
+fork_hash(const uint8_t key[16], const uint8_t *author, const uint8_t *parent) {
+  uint8_t message[sizeof(pf_key_t) + sizeof(pf_signature_t)];
+  uint64_t hash;
+  cpy(message, author, sizeof(pf_key_t));
+  cpy(message + sizeof(pf_key_t), parent, sizeof(pf_signature_t));
+  pico_crypto_hash((uint8_t *)&hash, sizeof(hash), key, 16, message, sizeof(message));
+  return (size_t)hash;
+}
+
+static fork_entry_t *
+fork_slot(const pf_fork_index_t *index, fork_entry_t *entries, size_t capacity, const uint8_t *author, const uint8_t *parent) {
+  size_t i = fork_hash(index->key, author, parent) & (capacity - 1);
+  for (;; i = (i + 1) & (capacity - 1)) {
+    fork_entry_t *e = &entries[i];
+    if (!e->used) return e;
+    if (0 == cmp(e->parent, parent, sizeof(pf_signature_t)) &&
+        0 == cmp(e->author, author, sizeof(pf_key_t))) return e;
+  }
+}
+
+static int
+fork_grow(pf_fork_index_t *index) {
+  size_t capacity = index->capacity * 2;
+  fork_entry_t *entries = salloc(capacity, sizeof(fork_entry_t));
+  if (entries == NULL) return EFAILED;
+
+  for (size_t i = 0; i < index->capacity; ++i) {
+    fork_entry_t *e = &index->entries[i];
+    if (e->used) *fork_slot(index, entries, capacity, e->author, e->parent) = *e;
+  }
+  free(index->entries);
+  index->entries = entries;
+  index->capacity = capacity;
+  return 0;
+}
+
+pf_fork_index_t *
+pf_fork_index_create(size_t capacity) {
+  pf_fork_index_t *index = salloc(1, sizeof(pf_fork_index_t));
+  if (index == NULL) return NULL;
+
+  index->capacity = 64;
+  while (index->capacity < capacity + capacity / 2) index->capacity *= 2;
+  index->entries = salloc(index->capacity, sizeof(fork_entry_t));
+  if (index->entries == NULL) {
+    free(index);
+    return NULL;
+  }
+  pico_crypto_random(index->key, sizeof(index->key));
+  return index;
+}
+
+int
+pf_fork_check(pf_fork_index_t *index, const pf_block_view_t *view, pf_equivocation_t *out) {
+  const uint8_t *parent = view->psig;
+  fork_entry_t *e;
+
+  if (view->author == NULL) return EFAILED;
+  /* an author may start any number of feeds */
+  if (parent == NULL) return 0;
+  /* keep load below 3/4 */
+  if ((index->len + 1) * 4 > index->capacity * 3 && fork_grow(index)) return EFAILED;
+
+  e = fork_slot(index, index->entries, index->capacity, view->author, parent);
+  if (!e->used) {
+    cpy(e->author, view->author, sizeof(pf_key_t));
+    cpy(e->parent, parent, sizeof(pf_signature_t));
+    cpy(e->child, view->id, sizeof(pf_signature_t));
+    e->used = 1;
+    index->len++;
+    return 0;
+  }
+
+  if (0 == cmp(e->child, view->id, sizeof(pf_signature_t))) return 0;
+
+  if (out != NULL) {
+    cpy(out->author, e->author, sizeof(pf_key_t));
+    cpy(out->parent, e->parent, sizeof(pf_signature_t));
+    cpy(out->first, e->child, sizeof(pf_signature_t));
+    cpy(out->second, view->id, sizeof(pf_signature_t));
+  }
+  return 1;
+}
+
+int
+pf_fork_index_feed(pf_fork_index_t *index, const pico_feed_t *feed, pf_equivocation_t *out, int max_out) {
+  pf_iterator_t iter = { .skip_verify = 1 };
+  pf_block_view_t view;
+  int found = 0;
+  int err;
+
+  while (0 == (err = pf_next_view(feed, &iter, &view))) {
+    int res = pf_fork_check(index, &view, out != NULL && found < max_out ? &out[found] : NULL);
+    if (res < 0) return res;
+    found += res;
+  }
+
+  return err < 0 ? err : found;
+}
+
+size_t
+pf_fork_index_size(const pf_fork_index_t *index) {
+  return index->len;
+}
+
+void
+pf_fork_index_destroy(pf_fork_index_t *index) {
+  if (index == NULL) return;
+  free(index->entries);
+  free(index);
+}
+
+/* --------------- Skip Links ---------------*/
+
+/* Skip heights as used by Bitcoin's CBlockIndex::pskip, any ancestor
+ * is reachable in O(log n) hops. */
+static inline int
+invert_lowest_one(int n) {
+  return n & (n - 1);
+}
+
+int
+pf_skip_index(int idx) {
+  if (idx < 2) return idx - 1;
+  return (idx & 1) ? invert_lowest_one(invert_lowest_one(idx - 1)) + 1 : invert_lowest_one(idx);
+}
+
+/* whether walking from idx towards k should take the skip link */
+static inline int
+take_skip(int idx, int k) {
+  const int skip = pf_skip_index(idx);
+  const int skip_prev = pf_skip_index(idx - 1);
+  return skip == k || (skip > k && !(skip_prev < skip - 2 && skip_prev >= k));
+}
+
+int
+pf_prove(const pico_feed_t *feed, int k, pico_feed_t *proof) {
+  ensure_magic(feed);
+  ensure_magic(proof);
+
+  pf_block_view_t view;
+  const int len = pf_len(feed);
+  int n = 0;
+  int err = 0;
+
+  if (k < 0 || k >= len) return EBOUNDS;
+
+  size_t *offsets = ualloc((size_t)len * sizeof(size_t));
+  if (offsets == NULL) return EFAILED;
+  offsets[0] = feed_head(feed);
+  for (int i = 1; i < len; ++i) {
+    offsets[i] = offsets[i - 1] + (size_t)pf_next_block_offset(feed->buffer + offsets[i - 1]);
+  }
+
+  if (pf_decode_view(feed->buffer + offsets[0], &view, 1) < 0) err = EFAILED;
+  else if (view.psig != NULL) err = EBOUNDS;
+
+  for (int idx = len - 1; !err; ) {
+    const size_t size = (size_t)pf_next_block_offset(feed->buffer + offsets[idx]);
+    if ((err = reserve_block(proof, size))) break;
+    cpy(proof->buffer + proof->tail, feed->buffer + offsets[idx], size);
+    commit_block(proof, size);
+    ++n;
+
+    if (idx == k) break;
+    const int target = pf_skip_index(idx);
+    if (!take_skip(idx, k) || target >= idx - 1) {
+      --idx;
+      continue;
+    }
+
+    /* the verifier can only follow links the block carries */
+    if (pf_decode_view(feed->buffer + offsets[idx], &view, 1) < 0) err = EFAILED;
+    else if (view_header(&view, HDR_SKIP) == NULL) err = EUNKHDR;
+    else if (0 != cmp(view_header(&view, HDR_SKIP), feed->buffer + offsets[target], sizeof(pf_signature_t))) err = EPARENT;
+    idx = target;
+  }
+
+  free(offsets);
+  return err ? err : n;
+}
+
+int
+pf_verify_proof(const pico_feed_t *proof, const pf_signature_t tip_id, int tip_idx, int k) {
+  ensure_magic(proof);
+
+  pf_iterator_t iter = {0};
+  pf_block_view_t view;
+  const uint8_t *psig = NULL;
+  const uint8_t *skip = NULL;
+  int idx = tip_idx;
+  int err;
+
+  if (k < 0 || k > tip_idx) return EBOUNDS;
+
+  while (0 == (err = pf_next_view(proof, &iter, &view))) {
+    if (iter.idx == 0) {
+      if (0 != cmp(view.id, tip_id, sizeof(pf_signature_t))) return EVERFAIL;
+    } else if (skip != NULL && 0 == cmp(skip, view.id, sizeof(pf_signature_t))) {
+      idx = pf_skip_index(idx);
+    } else if (psig != NULL && 0 == cmp(psig, view.id, sizeof(pf_signature_t))) {
+      idx = idx - 1;
+    } else return EPARENT;
+
+    if (idx < k) return EBOUNDS;
+    psig = view.psig;
+    skip = view_header(&view, HDR_SKIP);
+  }
+
+  if (err < 0) return err;
+  return idx == k && iter.idx >= 0 ? 0 : EBOUNDS;
+}
+
+/* --------------- Offset Index ---------------*/
+
+typedef struct {
+  const uint8_t *buffer;
+  size_t start;   /* first byte of range */
+  size_t end;     /* range end, blocks starting before it belong here */
+  size_t tail;    /* end of feed */
+  size_t first;   /* first boundary found, SIZE_MAX when none */
+  size_t exit;    /* first boundary past `end` */
+  size_t *offsets;
+  int len;
+  int capacity;
+  int err;
+  pthread_t thread;
+} boundary_scan_t;
+
+/* block size at p or 0 when bytes cannot start a block */
+static size_t
+block_shape(const uint8_t *buffer, size_t p, size_t tail) {
+  size_t data_size = 0;
+  int vo = 0;
+
+  if (p + sizeof(pf_signature_t) + 1 > tail) return 0;
+  const uint8_t *v = buffer + p + sizeof(pf_signature_t);
+  const size_t avail = tail - p - sizeof(pf_signature_t);
+  while (vo < 8 && (size_t)vo < avail) {
+    data_size |= (size_t)(v[vo] & 0x7F) << (vo * 7);
+    if (!(v[vo++] & 0x80)) break;
+    if (vo == 8 || (size_t)vo == avail) return 0;
+  }
+  /* encoder never emits trailing zero groups */
+  if (vo > 1 && v[vo - 1] == 0) return 0;
+  if (data_size == 0 || data_size > avail - (size_t)vo) return 0;
+
+  const size_t o = p + sizeof(pf_signature_t) + (size_t)vo;
+  const size_t end = o + data_size;
+  if (buffer[o] == 0) {
+    if (o + PF_HDR_PREFIX_SIZE > end) return 0;
+    int n = pf_header_size(buffer[o + 1]);
+    if (n < 0 || o + PF_HDR_PREFIX_SIZE + (size_t)n > end) return 0;
+  }
+  return end - p;
+}
+
+/* shape of p and psig linkage of its successor */
+static int
+plausible_boundary(const uint8_t *buffer, size_t p, size_t tail) {
+  pf_block_view_t next;
+  const size_t size = block_shape(buffer, p, tail);
+  if (!size) return 0;
+  if (p + size == tail) return 1;
+  if (!block_shape(buffer, p + size, tail)) return 0;
+
+  if (pf_decode_view(buffer + p + size, &next, 1) < 0 || next.psig == NULL) return 0;
+  return 0 == cmp(next.psig, buffer + p, sizeof(pf_signature_t));
+}
+
+static int
+boundary_push(boundary_scan_t *s, size_t offset) {
+  if (s->len == s->capacity) {
+    int capacity = s->capacity ? s->capacity * 2 : 256;
+    size_t *offsets = ralloc(s->offsets, (size_t)capacity * sizeof(size_t));
+    if (offsets == NULL) return EFAILED;
+    s->offsets = offsets;
+    s->capacity = capacity;
+  }
+  s->offsets[s->len++] = offset;
+  return 0;
+}
+
+/* sequential chain from `from`, collects boundaries below s->end */
+static int
+boundary_walk(boundary_scan_t *s, size_t from) {
+  size_t o = from;
+  s->len = 0;
+  s->first = from;
+  while (o < s->end) {
+    ssize_t n;
+    if (o + sizeof(pf_signature_t) + 1 > s->tail) return EFAILED;
+    n = pf_next_block_offset(s->buffer + o);
+    if (n <= 0 || (size_t)n > s->tail - o) return EFAILED;
+    if (boundary_push(s, o)) return EFAILED;
+    o += (size_t)n;
+  }
+  s->exit = o;
+  return 0;
+}
+
+static void *
+boundary_guess(void *arg) {
+  boundary_scan_t *s = arg;
+  s->first = SIZE_MAX;
+  for (size_t p = s->start; p < s->end; ++p) {
+    if (!plausible_boundary(s->buffer, p, s->tail)) continue;
+    s->err = boundary_walk(s, p);
+    return NULL;
+  }
+  return NULL;
+}
+
+int
+pf_index_build(const pico_feed_t *feed, int nthreads, pf_index_t *index) {
+  ensure_magic(feed);
+
+  const size_t head = feed_head(feed);
+  const size_t size = feed->tail - head;
+  int err = 0;
+
+  zro(index, sizeof(*index));
+  if (nthreads < 1) nthreads = 1;
+  if ((size_t)nthreads > size / PICOFEED_INDEX_MIN_CHUNK) nthreads = (int)(size / PICOFEED_INDEX_MIN_CHUNK);
+  if (nthreads < 1) nthreads = 1;
+
+  boundary_scan_t *scans = salloc((size_t)nthreads, sizeof(boundary_scan_t));
+  if (scans == NULL) return EFAILED;
+
+  for (int t = 0; t < nthreads; ++t) {
+    scans[t].buffer = feed->buffer;
+    scans[t].tail = feed->tail;
+    scans[t].start = head + size / (size_t)nthreads * (size_t)t;
+    scans[t].end = t == nthreads - 1 ? feed->tail : head + size / (size_t)nthreads * (size_t)(t + 1);
+  }
+
+  /* first range starts on a known boundary */
+  int spawned = 1;
+  for (; spawned < nthreads; ++spawned) {
+    if (0 != pthread_create(&scans[spawned].thread, NULL, boundary_guess, &scans[spawned])) break;
+  }
+  scans[0].err = boundary_walk(&scans[0], head);
+  for (int t = spawned; t < nthreads; ++t) boundary_guess(&scans[t]);
+  for (int t = 1; t < spawned; ++t) pthread_join(scans[t].thread, NULL);
+
+  /* stitch, rescanning ranges whose guess disagrees with the chain */
+  size_t cur = head;
+  int total = 0;
+  for (int t = 0; !err && t < nthreads; ++t) {
+    boundary_scan_t *s = &scans[t];
+    if (cur >= s->end) {
+      s->len = 0;
+      continue;
+    }
+    if (s->err || s->first != cur) err = boundary_walk(s, cur);
+    cur = s->exit;
+    total += s->len;
+  }
+
+  if (!err && total > 0) {
+    index->offsets = ualloc((size_t)total * sizeof(size_t));
+    if (index->offsets == NULL) err = EFAILED;
+  }
+  for (int t = 0; t < nthreads; ++t) {
+    if (!err && scans[t].len) {
+      cpy(index->offsets + index->len, scans[t].offsets, (size_t)scans[t].len * sizeof(size_t));
+      index->len += scans[t].len;
+    }
+    free(scans[t].offsets);
+  }
+  free(scans);
+
+  if (err) pf_index_free(index);
+  return err ? err : index->len;
+}
+
+void
+pf_index_free(pf_index_t *index) {
+  free(index->offsets);
+  zro(index, sizeof(*index));
+}
+
+/* --------------- Sidecar Index ---------------*/
+
+struct pf_sidecar_s {
+  const uint8_t *map;
+  size_t map_size;
+  uint64_t count;
+  uint64_t size;
+  const uint8_t *tip;
+};
+
+static inline void
+u32_encode(uint8_t *dst, uint32_t value) {
+  for (int i = 0; i < 4; ++i) dst[i] = (uint8_t)(value >> (i * 8));
+}
+
+static inline uint32_t
+u32_decode(const uint8_t *src) {
+  uint32_t value = 0;
+  for (int i = 0; i < 4; ++i) value |= (uint32_t)src[i] << (i * 8);
+  return value;
+}
+
+static inline off_t
+sidecar_page_at(uint64_t page) {
+  return (off_t)(PICOFEED_SIDECAR_HEADER + page * PICOFEED_SIDECAR_PAGE_SIZE);
+}
+
+static inline uint64_t
+sidecar_entry(const uint8_t *page, uint64_t slot) {
+  return u64_decode(page) + u32_decode(page + 8 + slot * 4);
+}
+
+int
+pf_sidecar_sync(const pico_feed_t *feed, const char *path) {
+  ensure_magic(feed);
+
+  uint8_t header[PICOFEED_SIDECAR_HEADER];
+  uint8_t page[PICOFEED_SIDECAR_PAGE_SIZE];
+  const size_t head = feed_head(feed);
+  const uint64_t feed_size = feed->tail - head + PICOFEED_MAGIC_SIZE;
+  uint64_t count = 0;
+  uint64_t offset = PICOFEED_MAGIC_SIZE;
+  int err = 0;
+
+  if (head != PICOFEED_MAGIC_SIZE) return EFAILED;
+
+  int fd = open(path, O_RDWR | O_CREAT, 0644);
+  if (fd < 0) return EFAILED;
+
+  /* resume after the stored tip when it is still ours */
+  if (sizeof(header) == pread(fd, header, sizeof(header), 0) &&
+      0 == cmp(header, PICOFEED_SIDECAR_MAGIC, PICOFEED_MAGIC_SIZE)) {
+    const uint64_t n = u64_decode(header + PICOFEED_MAGIC_SIZE);
+    const uint64_t size = u64_decode(header + PICOFEED_MAGIC_SIZE + 8);
+    const uint8_t *tip = header + PICOFEED_MAGIC_SIZE + 16;
+
+    if (n > 0 && size <= feed_size &&
+        sizeof(page) == pread(fd, page, sizeof(page), sidecar_page_at((n - 1) / PICOFEED_SIDECAR_PAGE))) {
+      const uint64_t last = sidecar_entry(page, (n - 1) % PICOFEED_SIDECAR_PAGE);
+      if (last + sizeof(pf_signature_t) <= feed_size &&
+          0 == cmp(feed->buffer + last, tip, sizeof(pf_signature_t)) &&
+          last + (uint64_t)pf_next_block_offset(feed->buffer + last) == size) {
+        count = n;
+        offset = size;
+      }
+    }
+  }
+  if (count == 0 && 0 != ftruncate(fd, 0)) err = EFAILED;
+
+  /* fill pages from the first one not yet complete */
+  uint64_t idx = count;
+  uint64_t page_no = count / PICOFEED_SIDECAR_PAGE;
+  const uint8_t *tip = NULL;
+  zro(page, sizeof(page));
+  if (!err && count % PICOFEED_SIDECAR_PAGE) {
+    if (sizeof(page) != pread(fd, page, sizeof(page), sidecar_page_at(page_no))) err = EFAILED;
+  }
+
+  while (!err && offset < feed_size) {
+    const uint64_t slot = idx % PICOFEED_SIDECAR_PAGE;
+    const ssize_t n = pf_next_block_offset(feed->buffer + offset);
+    if (n <= 0 || (uint64_t)n > feed_size - offset) {
+      err = EFAILED;
+      break;
+    }
+
+    if (slot == 0) u64_encode(page, offset);
+    if (offset - u64_decode(page) > UINT32_MAX) {
+      err = EBOUNDS;
+      break;
+    }
+    u32_encode(page + 8 + slot * 4, (uint32_t)(offset - u64_decode(page)));
+    tip = feed->buffer + offset;
+    offset += (uint64_t)n;
+    ++idx;
+
+    if (idx % PICOFEED_SIDECAR_PAGE == 0 || offset == feed_size) {
+      if (sizeof(page) != pwrite(fd, page, sizeof(page), sidecar_page_at(page_no))) err = EFAILED;
+      zro(page, sizeof(page));
+      ++page_no;
+    }
+  }
+
+  /* header last, readers never see entries beyond count */
+  if (!err && (tip != NULL || count == 0)) {
+    cpy(header, PICOFEED_SIDECAR_MAGIC, PICOFEED_MAGIC_SIZE);
+    u64_encode(header + PICOFEED_MAGIC_SIZE, idx);
+    u64_encode(header + PICOFEED_MAGIC_SIZE + 8, offset);
+    if (tip != NULL) cpy(header + PICOFEED_MAGIC_SIZE + 16, tip, sizeof(pf_signature_t));
+    else zro(header + PICOFEED_MAGIC_SIZE + 16, sizeof(pf_signature_t));
+    if (sizeof(header) != pwrite(fd, header, sizeof(header), 0)) err = EFAILED;
+  }
+
+  if (0 != close(fd)) err = EFAILED;
+  return err ? err : (int)idx;
+}
+
+pf_sidecar_t *
+pf_sidecar_open(const char *path, int feed_fd) {
+  struct stat st;
+  pf_sidecar_t *sc = NULL;
+  uint8_t id[sizeof(pf_signature_t)];
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return NULL;
+  if (0 != fstat(fd, &st) || (size_t)st.st_size < PICOFEED_SIDECAR_HEADER) goto fail;
+
+  sc = salloc(1, sizeof(pf_sidecar_t));
+  if (sc == NULL) goto fail;
+  sc->map_size = (size_t)st.st_size;
+  sc->map = mmap(NULL, sc->map_size, PROT_READ, MAP_SHARED, fd, 0);
+  if (sc->map == MAP_FAILED) {
+    sc->map = NULL;
+    goto fail;
+  }
+  close(fd);
+  fd = -1;
+
+  if (0 != cmp(sc->map, PICOFEED_SIDECAR_MAGIC, PICOFEED_MAGIC_SIZE)) goto fail;
+  sc->count = u64_decode(sc->map + PICOFEED_MAGIC_SIZE);
+  sc->size = u64_decode(sc->map + PICOFEED_MAGIC_SIZE + 8);
+  sc->tip = sc->map + PICOFEED_MAGIC_SIZE + 16;
+  if (sc->count > INT32_MAX) goto fail;
+  if (sc->count && (size_t)sidecar_page_at((sc->count - 1) / PICOFEED_SIDECAR_PAGE + 1) > sc->map_size) goto fail;
+
+  if (feed_fd >= 0 && sc->count) {
+    ssize_t last = pf_sidecar_offset(sc, -1, NULL);
+    if (sizeof(id) != pread(feed_fd, id, sizeof(id), last)) goto fail;
+    if (0 != cmp(id, sc->tip, sizeof(id))) goto fail;
+  }
+  return sc;
+
+fail:
+  if (fd >= 0) close(fd);
+  pf_sidecar_close(sc);
+  return NULL;
+}
+
+int
+pf_sidecar_len(const pf_sidecar_t *sidecar) {
+  return (int)sidecar->count;
+}
+
+ssize_t
+pf_sidecar_offset(const pf_sidecar_t *sidecar, int idx, size_t *size) {
+  const int len = (int)sidecar->count;
+  if (idx < 0) idx = len + idx;
+  if (idx < 0 || idx >= len) return EBOUNDS;
+
+  const uint8_t *page = sidecar->map + sidecar_page_at((uint64_t)idx / PICOFEED_SIDECAR_PAGE);
+  const uint64_t offset = sidecar_entry(page, (uint64_t)idx % PICOFEED_SIDECAR_PAGE);
+  if (size != NULL) {
+    uint64_t end = sidecar->size;
+    if (idx + 1 < len) {
+      const uint8_t *next = sidecar->map + sidecar_page_at((uint64_t)(idx + 1) / PICOFEED_SIDECAR_PAGE);
+      end = sidecar_entry(next, (uint64_t)(idx + 1) % PICOFEED_SIDECAR_PAGE);
+    }
+    *size = (size_t)(end - offset);
+  }
+  return (ssize_t)offset;
+}
+
+ssize_t
+pf_file_get(int fd, const pf_sidecar_t *sidecar, int idx, uint8_t *dst, size_t dst_size) {
+  size_t size = 0;
+  ssize_t offset = pf_sidecar_offset(sidecar, idx, &size);
+  if (offset < 0) return offset;
+  if (size > dst_size) return EBOUNDS;
+  if ((ssize_t)size != pread(fd, dst, size, offset)) return EFAILED;
+  return (ssize_t)size;
+}
+
+void
+pf_sidecar_close(pf_sidecar_t *sidecar) {
+  if (sidecar == NULL) return;
+  if (sidecar->map != NULL) munmap((void *)sidecar->map, sidecar->map_size);
+  free(sidecar);
+}
+
+/* --------------- File Export ---------------*/
+
+int
+pf_map(pico_feed_t *feed, int fd) {
+  struct stat st;
+  uint8_t *map;
+  size_t size, offset = PICOFEED_MAGIC_SIZE;
+  int len = 0;
+
+  if (0 != fstat(fd, &st) || st.st_size < PICOFEED_MAGIC_SIZE) return EFAILED;
+  size = (size_t)st.st_size;
+  map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  if (map == MAP_FAILED) return EFAILED;
+  if (0 != cmp(map, PiC0, PICOFEED_MAGIC_SIZE)) {
+    munmap(map, size);
+    return EFAILED;
+  }
+
+  /* stop before a block that is still being written */
+  while (offset + sizeof(pf_signature_t) + 2 <= size) {
+    const uint8_t *varint = map + offset + sizeof(pf_signature_t);
+    const size_t avail = size - offset - sizeof(pf_signature_t);
+    size_t v = 0;
+    while (v < avail && v < 8 && (varint[v] & 0x80)) ++v;
+    if (v == avail) break; /* size itself is cut short */
+
+    ssize_t n = pf_next_block_offset(map + offset);
+    if (n <= 0 || (size_t)n > size - offset) break;
+    offset += (size_t)n;
+    ++len;
+  }
+
+  zro(feed, offsetof(pico_feed_t, inline_buffer));
+  feed->buffer = map;
+  feed->capacity = size;
+  feed->head = PICOFEED_MAGIC_SIZE;
+  feed->tail = offset;
+  feed->flags = PF_FLAG_MAPPED;
+  return len;
+}
+
+static ssize_t
+send_range(int out_fd, int in_fd, off_t offset, size_t len) {
+  size_t sent = 0;
+#ifdef __linux__
+  while (sent < len) {
+    ssize_t n = sendfile(out_fd, in_fd, &offset, len - sent);
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && errno == EAGAIN) {
+      /* non-blocking socket, wait until it drains */
+      struct pollfd pfd = { .fd = out_fd, .events = POLLOUT };
+      if (poll(&pfd, 1, -1) < 0 && errno != EINTR) return EFAILED;
+      continue;
+    }
+    if (n <= 0) return EFAILED;
+    sent += (size_t)n;
+  }
+#else
+  uint8_t chunk[16384];
+  while (sent < len) {
+    size_t want = len - sent < sizeof(chunk) ? len - sent : sizeof(chunk);
+    ssize_t n = pread(in_fd, chunk, want, offset);
+    if (n <= 0 || write(out_fd, chunk, (size_t)n) != n) return EFAILED;
+    offset += n;
+    sent += (size_t)n;
+  }
+#endif
+  return (ssize_t)sent;
+}
+
+ssize_t
+pf_send(const pico_feed_t *feed, int feed_fd, int out_fd, int start_idx, int end_idx) {
+  ensure_magic(feed);
+
+  const int len = pf_len(feed);
+  start_idx = normalize_index(start_idx, len);
+  end_idx = normalize_index(end_idx, len);
+  if (end_idx < start_idx) return EBOUNDS;
+
+  const size_t start = block_offset_at(feed, start_idx);
+  const size_t end = block_offset_at(feed, end_idx);
+
+  if (PICOFEED_MAGIC_SIZE != write(out_fd, PiC0, PICOFEED_MAGIC_SIZE)) return EFAILED;
+  if (end == start) return PICOFEED_MAGIC_SIZE;
+
+  ssize_t sent = send_range(out_fd, feed_fd, (off_t)start, end - start);
+  return sent < 0 ? sent : sent + PICOFEED_MAGIC_SIZE;
+}
+
+/* --------------- Signing Service ---------------*/
+
+typedef struct sign_request_s {
+  struct sign_request_s *next;
+  pico_feed_t *feed;
+  void *ctx;
+  pf_keypair_t pair;
+  size_t len;
+  uint8_t body[];
+} sign_request_t;
+
+typedef struct {
+  pf_signer_t *signer;
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t wake;
+  sign_request_t *head;
+  sign_request_t *tail;
+  int stop;
+} sign_shard_t;
+
+struct pf_signer_s {
+  int nthreads;
+  sign_shard_t *shards;
+  pthread_mutex_t lock;
+  pthread_cond_t done;
+  pf_sign_completion_t *completions;
+  size_t head;
+  size_t len;
+  size_t capacity;
+  size_t pending;
+};
+
+static sign_shard_t *
+shard_of(pf_signer_t *signer, const pico_feed_t *feed) {
+  uint64_t h = (uint64_t)(uintptr_t)feed * 0x9E3779B97F4A7C15ull;
+  return &signer->shards[(h >> 32) % (uint64_t)signer->nthreads];
+}
+
+/* appends a run of requests for the same feed and author */
+static void
+sign_run(sign_request_t **run, int n, pf_sign_completion_t *out) {
+  pico_feed_t *feed = run[0]->feed;
+  const int len = pf_len(feed);
+
+  if (n > 1 && !feed->max_size && !(feed->flags & PF_FLAG_SKIP_LINKS)) {
+    const uint8_t *bodies[PICOFEED_SIGN_BATCH];
+    size_t lens[PICOFEED_SIGN_BATCH];
+    for (int i = 0; i < n; ++i) {
+      bodies[i] = run[i]->body;
+      lens[i] = run[i]->len;
+    }
+    const ssize_t height = pf_append_many(feed, bodies, lens, n, run[0]->pair);
+    for (int i = 0; i < n; ++i) out[i].result = height < 0 ? (int)height : len + i + 1;
+  } else {
+    for (int i = 0; i < n; ++i) {
+      out[i].result = (int)pf_append(feed, run[i]->body, run[i]->len, NULL, 0, run[i]->pair);
+    }
+  }
+}
+
+static void
+publish(pf_signer_t *signer, const pf_sign_completion_t *completions, size_t n) {
+  pthread_mutex_lock(&signer->lock);
+  if (signer->head == signer->len) signer->head = signer->len = 0;
+  if (signer->len + n > signer->capacity) {
+    size_t capacity = signer->capacity ? signer->capacity : 256;
+    while (capacity < signer->len + n) capacity <<= 1;
+    signer->completions = ralloc(signer->completions, capacity * sizeof(pf_sign_completion_t));
+    assert(signer->completions != NULL);
+    signer->capacity = capacity;
+  }
+  cpy(&signer->completions[signer->len], completions, n * sizeof(pf_sign_completion_t));
+  signer->len += n;
+  signer->pending -= n;
+  pthread_cond_broadcast(&signer->done);
+  pthread_mutex_unlock(&signer->lock);
+}
+
+static void *
+sign_worker(void *arg) {
+  sign_shard_t *shard = arg;
+  sign_request_t *batch[PICOFEED_SIGN_BATCH];
+  pf_sign_completion_t completions[PICOFEED_SIGN_BATCH];
+
+  while (1) {
+    int n = 0;
+    pthread_mutex_lock(&shard->lock);
+    while (!shard->stop && shard->head == NULL) pthread_cond_wait(&shard->wake, &shard->lock);
+    while (n < PICOFEED_SIGN_BATCH && shard->head != NULL) {
+      batch[n++] = shard->head;
+      shard->head = shard->head->next;
+    }
+    if (shard->head == NULL) shard->tail = NULL;
+    pthread_mutex_unlock(&shard->lock);
+    if (!n) break;
+
+    for (int i = 0; i < n;) {
+      int j = i + 1;
+      while (
+        j < n &&
+        batch[j]->feed == batch[i]->feed &&
+        0 == cmp(batch[j]->pair.seed, batch[i]->pair.seed, sizeof(batch[i]->pair.seed))
+      ) ++j;
+      sign_run(&batch[i], j - i, &completions[i]);
+      i = j;
+    }
+
+    for (int i = 0; i < n; ++i) {
+      completions[i].feed = batch[i]->feed;
+      completions[i].ctx = batch[i]->ctx;
+      wipe_pair(&batch[i]->pair);
+      free(batch[i]);
+    }
+    publish(shard->signer, completions, (size_t)n);
+  }
+  return NULL;
+}
+
+pf_signer_t *
+pf_signer_create(int nthreads) {
+  if (nthreads <= 0) nthreads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+  if (nthreads <= 0) nthreads = 1;
+
+  pf_signer_t *signer = salloc(1, sizeof(*signer));
+  if (signer == NULL) return NULL;
+  signer->nthreads = nthreads;
+  signer->shards = salloc(nthreads, sizeof(sign_shard_t));
+  assert(signer->shards != NULL);
+  pthread_mutex_init(&signer->lock, NULL);
+  pthread_cond_init(&signer->done, NULL);
+
+  for (int i = 0; i < nthreads; ++i) {
+    sign_shard_t *shard = &signer->shards[i];
+    shard->signer = signer;
+    pthread_mutex_init(&shard->lock, NULL);
+    pthread_cond_init(&shard->wake, NULL);
+    error_check(pthread_create(&shard->thread, NULL, sign_worker, shard));
+  }
+  return signer;
+}
+
+int
+pf_signer_submit(
+  pf_signer_t *signer,
+  pico_feed_t *feed,
+  const uint8_t *body,
+  size_t body_len,
+  pf_keypair_t pair,
+  void *ctx
+) {
+  if (feed == NULL || body == NULL || body_len == 0 || body[0] == 0) return EFAILED;
+  if (feed->flags & PF_FLAG_MAPPED) return EFAILED;
+
+  sign_request_t *req = ualloc(sizeof(*req) + body_len);
+  if (req == NULL) {
+    wipe_pair(&pair);
+    return EFAILED;
+  }
+  ensure_pair_pk(&pair);
+  req->next = NULL;
+  req->feed = feed;
+  req->ctx = ctx;
+  req->pair = pair;
+  wipe_pair(&pair);
+  req->len = body_len;
+  cpy(req->body, body, body_len);
+
+  pthread_mutex_lock(&signer->lock);
+  signer->pending++;
+  pthread_mutex_unlock(&signer->lock);
+
+  sign_shard_t *shard = shard_of(signer, feed);
+  pthread_mutex_lock(&shard->lock);
+  if (shard->tail != NULL) shard->tail->next = req;
+  else shard->head = req;
+  shard->tail = req;
+  pthread_cond_signal(&shard->wake);
+  pthread_mutex_unlock(&shard->lock);
+  return 0;
+}
+
+int
+pf_signer_poll(pf_signer_t *signer, pf_sign_completion_t *out, int max, int wait) {
+  if (max <= 0) return 0;
+  pthread_mutex_lock(&signer->lock);
+  while (wait && signer->head == signer->len && signer->pending) {
+    pthread_cond_wait(&signer->done, &signer->lock);
+  }
+  size_t n = signer->len - signer->head;
+  if (n > (size_t)max) n = (size_t)max;
+  cpy(out, &signer->completions[signer->head], n * sizeof(pf_sign_completion_t));
+  signer->head += n;
+  pthread_mutex_unlock(&signer->lock);
+  return (int)n;
+}
+
+void
+pf_signer_flush(pf_signer_t *signer) {
+  pthread_mutex_lock(&signer->lock);
+  while (signer->pending) pthread_cond_wait(&signer->done, &signer->lock);
+  pthread_mutex_unlock(&signer->lock);
+}
+
+void
+pf_signer_destroy(pf_signer_t *signer) {
+  if (signer == NULL) return;
+  pf_signer_flush(signer);
+
+  for (int i = 0; i < signer->nthreads; ++i) {
+    sign_shard_t *shard = &signer->shards[i];
+    pthread_mutex_lock(&shard->lock);
+    shard->stop = 1;
+    pthread_cond_signal(&shard->wake);
+    pthread_mutex_unlock(&shard->lock);
+  }
+  for (int i = 0; i < signer->nthreads; ++i) {
+    sign_shard_t *shard = &signer->shards[i];
+    pthread_join(shard->thread, NULL);
+    pthread_cond_destroy(&shard->wake);
+    pthread_mutex_destroy(&shard->lock);
+  }
+
+  pthread_cond_destroy(&signer->done);
+  pthread_mutex_destroy(&signer->lock);
+  free(signer->completions);
+  free(signer->shards);
+  free(signer);
+}
+
+/* --------------- Shared Cache ---------------*/
+
+#define CACHE_MAGIC 0x30434650u /* PFC0 */
+#define CACHE_NAME_MAX 255
+#define CACHE_OPEN_RETRIES 1000 /* x 1ms waiting on a concurrent creator */
+#define CACHE_SPIN_MAX (1u << 16) /* reader spins before treating a slot as torn */
+
+/* robust mutexes let a cache outlive a publisher that died holding
+ * the lock, without them such a cache must be unlinked and recreated */
+#ifndef PICOFEED_CACHE_ROBUST
+#if defined(__linux__) && defined(EOWNERDEAD)
+#define PICOFEED_CACHE_ROBUST 1
+#else
+#define PICOFEED_CACHE_ROBUST 0
+#endif
+#endif
+
+/* seqlock, generation is odd while a slot is rewritten */
+typedef struct {
+  _Atomic uint64_t generation;
+  uint8_t key[32];
+  uint8_t used;
+} cache_slot_t;
+
+typedef struct {
+  _Atomic uint32_t magic;
+  uint32_t nslots;
+  pthread_mutex_t lock;
+  cache_slot_t slots[PICOFEED_CACHE_SLOTS];
+} cache_directory_t;
+
+struct pf_cache_s {
+  cache_directory_t *dir;
+  char name[CACHE_NAME_MAX - 31]; /* leaves room for the snapshot suffix */
+};
+
+static void
+snapshot_name(char *dst, const char *name, size_t slot, uint64_t generation) {
+  snprintf(dst, CACHE_NAME_MAX + 1, "%s.%zx.%llx", name, slot, (unsigned long long)generation);
+}
+
+static size_t
+cache_home(const uint8_t key[32]) {
+  uint64_t h;
+  cpy(&h, key, sizeof(h));
+  return (size_t)((h * 0x9E3779B97F4A7C15ull) >> 32) % PICOFEED_CACHE_SLOTS;
+}
+
+/* takes the directory lock, repairing slots left by a publisher that died holding it */
+static int
+cache_lock(pf_cache_t *cache) {
+  cache_directory_t *dir = cache->dir;
+  int err = pthread_mutex_lock(&dir->lock);
+#if PICOFEED_CACHE_ROBUST
+  char name[CACHE_NAME_MAX + 1];
+  if (err != EOWNERDEAD) return err;
+
+  for (size_t i = 0; i < PICOFEED_CACHE_SLOTS; ++i) {
+    uint64_t g = atomic_load_explicit(&dir->slots[i].generation, memory_order_relaxed);
+    /* the successor's snapshot was written before the slot was opened,
+     * completing the bump keeps it attachable */
+    if (g & 1) atomic_store_explicit(&dir->slots[i].generation, ++g, memory_order_release);
+    if (!g) continue;
+    /* the snapshot being replaced and one written but never published */
+    if (g > 2) {
+      snapshot_name(name, cache->name, i, g - 2);
+      shm_unlink(name);
+    }
+    snapshot_name(name, cache->name, i, g + 2);
+    shm_unlink(name);
+  }
+  return pthread_mutex_consistent(&dir->lock);
+#else
+  return err;
+#endif
+}
+
+/* finds the slot of a key without locking
+ * @return slot index, -1 when missing or -2 when a slot stayed odd
+ * for CACHE_SPIN_MAX reads, generation of the matched slot */
+static ssize_t
+cache_find(const cache_directory_t *dir, const uint8_t key[32], uint64_t *generation) {
+  size_t i = cache_home(key);
+  for (size_t probe = 0; probe < PICOFEED_CACHE_SLOTS; ++probe, i = (i + 1) % PICOFEED_CACHE_SLOTS) {
+    const cache_slot_t *slot = &dir->slots[i];
+    uint64_t g1, g2;
+    int used, match;
+    do {
+      unsigned spins = 0;
+      while ((g1 = atomic_load_explicit(&slot->generation, memory_order_acquire)) & 1) {
+        if (++spins == CACHE_SPIN_MAX) return -2;
+      }
+      used = slot->used;
+      match = used && 0 == cmp(slot->key, key, 32);
+      atomic_thread_fence(memory_order_acquire);
+      g2 = atomic_load_explicit(&slot->generation, memory_order_relaxed);
+    } while (g1 != g2);
+    if (!used) return -1;
+    if (match) {
+      *generation = g1;
+      return (ssize_t)i;
+    }
+  }
+  return -1;
+}
+
+/* ~1ms pause while another process finishes creating the directory */
+static void
+cache_backoff(void) {
+  const struct timespec ts = { .tv_sec = 0, .tv_nsec = 1000000 };
+  nanosleep(&ts, NULL);
+}
+
+pf_cache_t *
+pf_cache_open(const char *name, int create) {
+  if (name == NULL || name[0] != '/' || strlen(name) > CACHE_NAME_MAX - 32) return NULL;
+
+  int created = 0;
+  int fd = shm_open(name, O_RDWR, 0);
+  if (fd < 0 && create) {
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    created = fd >= 0;
+    if (fd < 0) fd = shm_open(name, O_RDWR, 0);
+  }
+  if (fd < 0) return NULL;
+  if (created && 0 != ftruncate(fd, sizeof(cache_directory_t))) {
+    close(fd);
+    shm_unlink(name);
+    return NULL;
+  }
+
+  /* the creator may not have sized the object yet, mapping it early would SIGBUS */
+  for (int attempt = 0; !created; ++attempt) {
+    struct stat st;
+    if (0 != fstat(fd, &st) || attempt == CACHE_OPEN_RETRIES) {
+      close(fd);
+      return NULL;
+    }
+    if ((size_t)st.st_size >= sizeof(cache_directory_t)) break;
+    cache_backoff();
+  }
+
+  cache_directory_t *dir = mmap(NULL, sizeof(cache_directory_t), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (dir == MAP_FAILED) return NULL;
+
+  if (created) {
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+#if PICOFEED_CACHE_ROBUST
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+#endif
+    pthread_mutex_init(&dir->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+    dir->nslots = PICOFEED_CACHE_SLOTS;
+    atomic_store_explicit(&dir->magic, CACHE_MAGIC, memory_order_release);
+  } else {
+    int attempt = 0;
+    while (CACHE_MAGIC != atomic_load_explicit(&dir->magic, memory_order_acquire) && attempt++ < CACHE_OPEN_RETRIES) {
+      cache_backoff();
+    }
+    if (CACHE_MAGIC != atomic_load_explicit(&dir->magic, memory_order_acquire) || PICOFEED_CACHE_SLOTS != dir->nslots) {
+      munmap(dir, sizeof(cache_directory_t));
+      return NULL;
+    }
+  }
+
+  pf_cache_t *cache = salloc(1, sizeof(*cache));
+  if (cache == NULL) {
+    munmap(dir, sizeof(cache_directory_t));
+    return NULL;
+  }
+  cache->dir = dir;
+  strcpy(cache->name, name);
+  return cache;
+}
+
+static int
+write_snapshot(const char *name, const pico_feed_t *feed) {
+  const size_t head = feed_head(feed);
+  const size_t size = PICOFEED_MAGIC_SIZE + feed->tail - head;
+  int err = EFAILED;
+
+  int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0) return EFAILED;
+  if (0 == ftruncate(fd, (off_t)size)) {
+    uint8_t *dst = mmap(NULL, size, PROT_WRITE, MAP_SHARED, fd, 0);
+    if (dst != MAP_FAILED) {
+      cpy(dst, PiC0, PICOFEED_MAGIC_SIZE);
+      cpy(dst + PICOFEED_MAGIC_SIZE, feed->buffer + head, feed->tail - head);
+      munmap(dst, size);
+      err = 0;
+    }
+  }
+  close(fd);
+  if (err) shm_unlink(name);
+  return err;
+}
+
+int64_t
+pf_cache_publish(pf_cache_t *cache, const uint8_t key[32], const pico_feed_t *feed) {
+  ensure_magic(feed);
+  cache_directory_t *dir = cache->dir;
+  char name[CACHE_NAME_MAX + 1];
+  int64_t result = EFAILED;
+
+  if (0 != cache_lock(cache)) return EFAILED;
+  size_t i = cache_home(key);
+  size_t probe = 0;
+  for (; probe < PICOFEED_CACHE_SLOTS; ++probe, i = (i + 1) % PICOFEED_CACHE_SLOTS) {
+    if (!dir->slots[i].used || 0 == cmp(dir->slots[i].key, key, 32)) break;
+  }
+
+  if (probe < PICOFEED_CACHE_SLOTS) {
+    cache_slot_t *slot = &dir->slots[i];
+    const uint64_t prev = atomic_load_explicit(&slot->generation, memory_order_relaxed);
+    const uint64_t next = prev + 2;
+
+    snapshot_name(name, cache->name, i, next);
+    shm_unlink(name); /* leftover of a crashed publisher */
+    if (0 == write_snapshot(name, feed)) {
+      atomic_store_explicit(&slot->generation, prev + 1, memory_order_relaxed);
+      atomic_thread_fence(memory_order_release);
+      cpy(slot->key, key, 32);
+      slot->used = 1;
+      atomic_store_explicit(&slot->generation, next, memory_order_release);
+
+      if (prev) {
+        snapshot_name(name, cache->name, i, prev);
+        shm_unlink(name);
+      }
+      result = (int64_t)next;
+    }
+  }
+  pthread_mutex_unlock(&dir->lock);
+  return result;
+}
+
+int
+pf_cache_attach(pf_cache_t *cache, const uint8_t key[32], pico_feed_t *feed, uint64_t *generation) {
+  char name[CACHE_NAME_MAX + 1];
+  uint64_t g;
+
+  /* retries when the snapshot is replaced between lookup and open */
+  for (int attempt = 0; attempt < 16; ++attempt) {
+    ssize_t i = cache_find(cache->dir, key, &g);
+    if (i == -2 && PICOFEED_CACHE_ROBUST && 0 == cache_lock(cache)) {
+      pthread_mutex_unlock(&cache->dir->lock);
+      continue;
+    }
+    if (i < 0) return EFAILED;
+
+    snapshot_name(name, cache->name, (size_t)i, g);
+    int fd = shm_open(name, O_RDONLY, 0);
+    if (fd < 0) continue;
+    int len = pf_map(feed, fd);
+    close(fd);
+    if (len < 0) return len;
+    if (generation != NULL) *generation = g;
+    return len;
+  }
+  return EFAILED;
+}
+
+uint64_t
+pf_cache_generation(pf_cache_t *cache, const uint8_t key[32]) {
+  uint64_t g = 0;
+  return cache_find(cache->dir, key, &g) < 0 ? 0 : g;
+}
+
+void
+pf_cache_close(pf_cache_t *cache) {
+  if (cache == NULL) return;
+  munmap(cache->dir, sizeof(cache_directory_t));
+  free(cache);
+}
+
+int
+pf_cache_unlink(const char *name) {
+  char snapshot[CACHE_NAME_MAX + 1];
+  pf_cache_t *cache = pf_cache_open(name, 0);
+  if (cache == NULL) return EFAILED;
+
+  for (size_t i = 0; i < PICOFEED_CACHE_SLOTS; ++i) {
+    const uint64_t g = atomic_load(&cache->dir->slots[i].generation);
+    if (!g) continue;
+    snapshot_name(snapshot, name, i, g);
+    shm_unlink(snapshot);
+  }
+  pf_cache_close(cache);
+  return shm_unlink(name) ? EFAILED : 0;
+}
+
 #undef cpy
+#undef mov
 #undef cmp
 #undef zro
 #undef ualloc
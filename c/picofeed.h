@@ -5,6 +5,7 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 
 #define NWSN "Network Without Super Node"
 #define LICENSE "AGPL"
@@ -13,6 +14,10 @@
 #define PiC0 "PIC0"
 #define PICOFEED_MAGIC_SIZE 4
 
+/* bumped whenever the layout of a public struct changes,
+ * also the soname of the shared library */
+#define PICOFEED_ABI_VERSION 1
+
 /*---------------- POP-01: IDENTITY ----------------*/
 typedef uint8_t pf_key_t[32];
 typedef uint8_t pf_signature_t[64];
@@ -44,13 +49,112 @@ int pico_crypto_verify(
   size_t message_len,
   const pf_key_t pk
 );
+/* same as sign/verify over the concatenation of all message segments,
+ * with PICO_EXTERN_CRYPTO the defaults gather the segments and call
+ * the one-shot primitives, #define PICO_EXTERN_CRYPTO_IOV to provide them.
+ */
+void pico_crypto_sign_iov(
+  pf_signature_t signature,
+  const struct iovec *message,
+  int iovcnt,
+  pf_keypair_t pair
+);
+int pico_crypto_verify_iov(
+  const pf_signature_t signature,
+  const struct iovec *message,
+  int iovcnt,
+  const pf_key_t pk
+);
+/* keyed BLAKE2b, key may be NULL when key_size == 0.
+ * Required since watermarks, PICO_EXTERN_CRYPTO builds must provide it.
+ */
+void pico_crypto_hash(
+  uint8_t *hash,
+  size_t hash_size,
+  const uint8_t *key,
+  size_t key_size,
+  const uint8_t *message,
+  size_t message_len
+);
 /* end of crypto */
 
+#ifndef PICO_EXTERN_CRYPTO
+/* --------------- Crypto Backends ---------------*/
+#define PICOFEED_CRYPTO_BACKENDS 8
+
+typedef struct {
+  const uint8_t *signature;
+  const uint8_t *message;
+  size_t message_len;
+  const uint8_t *pk;
+} pf_verify_item_t;
+
+/**
+ * Signature primitives used by the built-in crypto.
+ * The portable monocypher backend is always registered and active
+ * by default, hosts may register other implementations and pick
+ * one at runtime. Every `pico_crypto_*` signing, verification and
+ * key derivation call goes through the active backend.
+ *
+ * This is a pluggable registry only, no batched or vectorized
+ * backend ships with the library. `verify_batch` receives whole
+ * verify pool ranges so such a backend can be added; monocypher
+ * has no multi-scalar multiplication and checks items one by one.
+ */
+typedef struct {
+  const char *name;
+  /** @return non-zero when the running CPU supports this backend,
+   * NULL when always available */
+  int (*available)(void);
+  void (*keypair)(pf_keypair_t *pair);
+  void (*sign)(pf_signature_t signature, const uint8_t *message, size_t message_len, const pf_keypair_t *pair);
+  /** @return 0 when valid */
+  int (*verify)(const pf_signature_t signature, const uint8_t *message, size_t message_len, const pf_key_t pk);
+  /** @return 0 when all valid, results[i] is 0 for each valid item */
+  int (*verify_batch)(const pf_verify_item_t *items, int n, int *results);
+  void (*public_key)(pf_key_t pk, const uint8_t seed[32]);
+  /** optional, NULL gathers the segments for `sign` */
+  void (*sign_iov)(pf_signature_t signature, const struct iovec *message, int iovcnt, const pf_keypair_t *pair);
+  /** optional, NULL gathers the segments for `verify` */
+  int (*verify_iov)(const pf_signature_t signature, const struct iovec *message, int iovcnt, const pf_key_t pk);
+} pf_crypto_backend_t;
+
+/**
+ * @brief Adds a backend, it is not activated
+ * @return 0 on success, EFAILED when the registry is full
+ */
+int pico_crypto_register(const pf_crypto_backend_t *backend);
+
+/**
+ * @brief Activates a registered backend
+ *
+ * Must not race with signing or verification.
+ *
+ * @param name backend name or NULL for the most recently
+ * registered backend available on this CPU
+ * @return the active backend or NULL when `name` is unavailable
+ */
+const pf_crypto_backend_t *pico_crypto_select(const char *name);
+
+/**
+ * @brief Currently active backend
+ */
+const pf_crypto_backend_t *pico_crypto_backend(void);
+
+/**
+ * @brief Verifies many signatures with the active backend
+ * @param results optional, receives 0 for each valid item
+ * @return 0 when all are valid
+ */
+int pico_crypto_verify_batch(const pf_verify_item_t *items, int n, int *results);
+#endif /* PICO_EXTERN_CRYPTO */
+
 typedef uint8_t pf_header_id_t;
 
 typedef enum {
   HDR_AUTHOR = 1,
-  HDR_PSIG = 2
+  HDR_PSIG = 2,
+  HDR_SKIP = 0x7F /* id of an older ancestor, see PF_FLAG_SKIP_LINKS */
 } pico_header_t;
 
 typedef struct {
@@ -67,6 +171,18 @@ typedef struct pf_block_s {
   uint8_t verified;
 } pf_block_t;
 
+/* Borrowed block, all pointers reference the decoded buffer
+ * which must outlive the view. */
+typedef struct pf_block_view_s {
+  const uint8_t *id;     /* signature, first 64 bytes of block */
+  const uint8_t *body;
+  const uint8_t *author; /* NULL when absent */
+  const uint8_t *psig;   /* NULL when absent */
+  size_t len;
+  size_t block_size;
+  uint8_t verified;
+} pf_block_view_t;
+
 typedef struct {
   const uint8_t *cursor;
   const uint8_t *end;
@@ -79,7 +195,8 @@ typedef enum {
   EUNKHDR = -2,
   EDUPHDR = -3,
   EVERFAIL = -4,
-  EBOUNDS = -5
+  EBOUNDS = -5,
+  EPARENT = -6
 } pf_decode_error_t;
 
 /**
@@ -92,6 +209,14 @@ typedef enum {
  */
 int pf_decode_block(const uint8_t *bytes, pf_block_t *block, int no_verify);
 
+/**
+ * @brief decodes block without copying the id
+ * @return bytes-read or pf_decode_error_t
+ *
+ * Same as `pf_decode_block()` but only pointers into `bytes` are stored.
+ */
+int pf_decode_view(const uint8_t *bytes, pf_block_view_t *view, int no_verify);
+
 /**
  * @brief Size of encoded header section only
  * @param headers header vector, may be NULL when nheaders == 0
@@ -126,6 +251,35 @@ ssize_t pf_create_block(
   pf_keypair_t pair
 );
 
+/**
+ * @brief creates a v8 block without copying the body.
+ * Only signature, size and headers are written to dst, the
+ * block is the prefix followed by the body segments in order.
+ * @param dst expected length >= pf_sizeof(body_len, headers, nheaders) - body_len
+ * @param body body segments, first byte must be non-zero
+ * @param iovcnt number of segments
+ * @param headers header vector, may be NULL when nheaders == 0
+ * @param nheaders number of headers
+ * @param pair secret key
+ * @return number of prefix bytes written or < 1 on error
+ */
+ssize_t pf_create_block_iov(
+  uint8_t *dst,
+  const struct iovec *body,
+  int iovcnt,
+  const pf_header_t *headers,
+  size_t nheaders,
+  pf_keypair_t pair
+);
+
+/**
+ * @brief verifies a single block spread across multiple buffers
+ * @param block segments holding exactly one block
+ * @param iovcnt number of segments
+ * @return block size or < 0 on error
+ */
+ssize_t pf_verify_block_iov(const struct iovec *block, int iovcnt);
+
 /**
  * @brief Size of a header value in bytes
  * @return size or < 0 on unknown/unsupported header id
@@ -158,19 +312,42 @@ const void *pf_block_header(const pf_block_t *block, pf_header_id_t id);
 ssize_t pf_next_block_offset(const uint8_t *buffer);
 
 /* --------------- POP-0201 Feed ---------------*/
+#define PICOFEED_DIGEST_SIZE 32
+
+/* rolling block-id digests, see `pf_digest()` */
+typedef struct pf_digests_s pf_digests_t;
+
+/* feeds up to this size (including magic) are stored inside pico_feed_t.
+ * Part of the struct layout, fixed so all translation units agree on it.
+ */
+#define PICOFEED_INLINE_CAPACITY 256
+
+/* pf_append() writes HDR_SKIP links, feed must start at genesis,
+ * appends to sliced, shifted or capped feeds fail with EBOUNDS */
+#define PF_FLAG_SKIP_LINKS 0x1
+/* buffer is a read-only file mapping owned by the feed, see pf_map() */
+#define PF_FLAG_MAPPED 0x2
+
 typedef struct {
   size_t tail;
+  size_t head;
   size_t capacity;
+  size_t max_size;
+  size_t block_hint;
   uint32_t flags;
   uint8_t reserved[8];
   uint8_t *buffer;
+  pf_digests_t *digests;
+  uint8_t inline_buffer[PICOFEED_INLINE_CAPACITY];
 } pico_feed_t;
 
 /**
  * @brief Initializes a writable feed
  *
- * Allocates memory which must be released
- * using `pf_deinit()`.
+ * Small feeds live in `inline_buffer`, memory is allocated
+ * once they outgrow it and must be released using `pf_deinit()`.
+ * An initialized feed may point into itself, it must not be
+ * moved or copied by assignment or memcpy(), use `pf_clone()`.
  *
  * V8 feeds reserve the first four bytes for the `PIC0` magic.
  */
@@ -196,6 +373,12 @@ typedef struct pf_iterator_s {
  */
 int pf_next(const pico_feed_t *feed, pf_iterator_t *iter);
 
+/**
+ * @brief Iterates blocks as views, `iter->block` is left untouched
+ * @return error < 0, has_more = 0, done = 1
+ */
+int pf_next_view(const pico_feed_t *feed, pf_iterator_t *iter, pf_block_view_t *view);
+
 /**
  * @brief Appends block to a writable feed
  *
@@ -221,6 +404,27 @@ ssize_t pf_append(
   pf_keypair_t pair
 );
 
+/**
+ * @brief Appends many blocks with one reservation
+ *
+ * Same result as calling `pf_append()` for each body in order,
+ * every block links to the one created before it.
+ *
+ * @param bodies application bodies, first byte must be non-zero
+ * @param lens length of each body
+ * @param n number of bodies
+ * @param pair author's secret
+ * @return new block height or < 0 on error, nothing is appended
+ * when a body is invalid
+ */
+ssize_t pf_append_many(
+  pico_feed_t *feed,
+  const uint8_t *const *bodies,
+  const size_t *lens,
+  int n,
+  pf_keypair_t pair
+);
+
 /**
  * @brief Count Blocks in a Feed
  * @return block height
@@ -230,8 +434,34 @@ int pf_len(const pico_feed_t *feed);
 /**
  * @brief Remove blocks
  * @param len negative values wrap from end
+ * @return 0 on success, EFAILED for mapped feeds
+ */
+int pf_truncate(pico_feed_t *feed, int len);
+
+/**
+ * @brief Drops the oldest blocks
+ *
+ * Advances the feed head without moving memory,
+ * retained blocks are compacted to the front once the
+ * head crosses half the buffer capacity.
+ * Rolling digests restart at the new head and are rebuilt
+ * by the next `pf_digest()`, appends to capped feeds do not
+ * rehash the retained blocks.
+ *
+ * @param n number of blocks to drop
+ * @return number of blocks dropped
  */
-void pf_truncate(pico_feed_t *feed, int len);
+int pf_shift(pico_feed_t *feed, int n);
+
+/**
+ * @brief Caps a feed to a maximum size
+ *
+ * Capped feeds behave like ring-buffers, `pf_append()` drops
+ * the oldest blocks to make room for new ones.
+ *
+ * @param max_size maximum size of blocks in bytes, 0 to disable
+ */
+void pf_set_max_size(pico_feed_t *feed, size_t max_size);
 
 /**
  * @brief Get block at index
@@ -246,6 +476,36 @@ int pf_get(const pico_feed_t *feed, pf_block_t *block, int idx);
  */
 int pf_last(const pico_feed_t *feed, pf_block_t *block);
 
+/**
+ * @brief Hashes the first `height` blocks of a feed
+ *
+ * Unkeyed `pico_crypto_hash()` over the raw block bytes,
+ * recorded next to a checkpoint for `pf_verify_from()`.
+ *
+ * @return 0 on success, EBOUNDS when the feed is shorter than height
+ */
+int pf_prefix_hash(const pico_feed_t *feed, int height, uint8_t out[32]);
+
+/**
+ * @brief Verifies a feed that extends a known-good prefix
+ *
+ * Blocks below the checkpoint are parsed but their signatures
+ * are not checked; instead their bytes must hash to `trusted_hash`
+ * (see `pf_prefix_hash()`) and the checkpoint block at height
+ * `trusted_height` (index `trusted_height - 1`) must carry `trusted_id`.
+ * Signatures are checked for the checkpoint and all blocks above it,
+ * PSIG linkage is checked for every block in the feed.
+ *
+ * Pass `trusted_height = 0` (and NULL id/hash) to verify everything.
+ *
+ * @param feed feed to verify
+ * @param trusted_height number of blocks previously verified
+ * @param trusted_id id of the last previously verified block
+ * @param trusted_hash `pf_prefix_hash()` of the first trusted_height blocks
+ * @return feed height or pf_decode_error_t
+ */
+int pf_verify_from(const pico_feed_t *feed, int trusted_height, const pf_signature_t trusted_id, const uint8_t trusted_hash[32]);
+
 typedef enum {
   OK = 0,
   UNRELATED,
@@ -259,6 +519,52 @@ typedef enum {
  */
 pf_diff_error_t pf_diff(const pico_feed_t *a, const pico_feed_t *b, int *out);
 
+typedef struct {
+  int status; /* pf_diff_error_t or pf_decode_error_t when remote is corrupt */
+  int diff;   /* same as `out` of pf_diff() when status == OK */
+} pf_diff_result_t;
+
+/**
+ * @brief pf_diff() of one local feed against many remotes
+ *
+ * The local feed is walked and verified once, remotes are aligned
+ * through an id lookup instead of re-walking `local` per peer.
+ *
+ * @param out one result per remote
+ * @return 0 or pf_decode_error_t when local could not be read
+ */
+int pf_diff_many(const pico_feed_t *local, const pico_feed_t *const *remotes, int n, pf_diff_result_t *out);
+
+/**
+ * @brief Content address of the entire feed
+ *
+ * Digests are chained over block ids:
+ * `D(0) = 0`, `D(h) = BLAKE2b-256(D(h - 1) || id(h - 1))`.
+ * The first call indexes the feed, afterwards digests are
+ * kept up to date by `pf_append()` and `pf_truncate()`.
+ * Updates the digest table stored in the feed, so it is not
+ * thread-safe and must not race other calls on the same feed.
+ *
+ * @param out digest destination
+ * @return feed height or < 0 on error
+ */
+int pf_digest(pico_feed_t *feed, uint8_t out[PICOFEED_DIGEST_SIZE]);
+
+/**
+ * @brief Content address of the first `height` blocks
+ * Same thread-safety as `pf_digest()`.
+ * @param height 0..len, negative values wrap from end
+ * @return 0 on success, EBOUNDS when height is out of range
+ */
+int pf_digest_at(pico_feed_t *feed, int height, uint8_t out[PICOFEED_DIGEST_SIZE]);
+
+/**
+ * @brief Compares two feeds by digest
+ * Same thread-safety as `pf_digest()`.
+ * @return 1 when both feeds contain the same blocks, 0 otherwise
+ */
+int pf_equal(pico_feed_t *a, pico_feed_t *b);
+
 /**
  * @brief Creates a copy
  *
@@ -279,6 +585,549 @@ void pf_clone(pico_feed_t *dst, const pico_feed_t *src);
  */
 int pf_slice(pico_feed_t *dst, const pico_feed_t *src, int start_idx, int end_idx);
 
+/* --------------- Watermark ---------------*/
+#define PICOFEED_WATERMARK_MAGIC "PIW0"
+#define PICOFEED_WATERMARK_SIZE (PICOFEED_MAGIC_SIZE + 8 + 8 + 64 + 32)
+
+/**
+ * Records how far a feed has been verified.
+ * Stored in a sidecar file next to the feed (e.g. `feed.pic.pfw`)
+ * so that a restart only has to re-hash the verified prefix
+ * and verify the signatures of blocks appended since.
+ */
+typedef struct {
+  uint64_t height;        /* blocks from the feed head */
+  uint64_t size;          /* bytes from the feed head */
+  pf_signature_t tip;
+  uint8_t checksum[32];   /* keyed hash of those bytes */
+} pf_watermark_t;
+
+/**
+ * @brief Records the current state of an already verified feed
+ * @param key checksum key, may be NULL for an unkeyed checksum
+ * @return 0 on success, < 0 on error
+ */
+int pf_watermark(const pico_feed_t *feed, pf_watermark_t *wm, const uint8_t key[32]);
+
+/**
+ * @brief Writes watermark to sidecar file, replaced atomically via "<path>.tmp"
+ * @return 0 on success, < 0 on error
+ */
+int pf_watermark_save(const pf_watermark_t *wm, const char *path);
+
+/**
+ * @brief Reads watermark from sidecar file
+ * @return 0 on success, < 0 on missing or malformed file
+ */
+int pf_watermark_load(pf_watermark_t *wm, const char *path);
+
+/**
+ * @brief Verifies a feed using a previously recorded watermark
+ *
+ * Re-hashes the watermarked byte prefix instead of checking
+ * its signatures, then behaves like `pf_verify_from()`.
+ * Watermarks are relative to the feed head, after `pf_shift()`
+ * the old prefix no longer matches and EVERFAIL is returned.
+ *
+ * @return feed height or pf_decode_error_t
+ */
+int pf_verify_watermark(const pico_feed_t *feed, const pf_watermark_t *wm, const uint8_t key[32]);
+
+/* --------------- Verify Pool ---------------*/
+#define PICOFEED_VERIFY_BATCH 64
+
+/**
+ * Verifies many feeds in parallel.
+ * Feeds are split into batches of PICOFEED_VERIFY_BATCH blocks,
+ * each worker owns a deque of batches and steals from others when idle.
+ */
+typedef struct pf_verify_pool_s pf_verify_pool_t;
+
+/**
+ * @brief Invoked from a worker thread once a feed is verified
+ * @param result feed height or pf_decode_error_t
+ */
+typedef void (*pf_verify_cb)(const pico_feed_t *feed, int result, void *ctx);
+
+/**
+ * @brief Starts a pool of verification threads
+ * @param nthreads number of workers, 0 for one per online CPU
+ * @return pool or NULL on error
+ */
+pf_verify_pool_t *pf_verify_pool_create(int nthreads);
+
+/**
+ * @brief Queues a feed for verification
+ *
+ * Checks signatures and PSIG linkage of every block,
+ * the feed must not be modified until `cb` was invoked.
+ *
+ * @return 0 when queued, < 0 on error
+ */
+int pf_verify_pool_submit(pf_verify_pool_t *pool, const pico_feed_t *feed, pf_verify_cb cb, void *ctx);
+
+/**
+ * @brief Blocks until all submitted feeds are verified
+ */
+void pf_verify_pool_wait(pf_verify_pool_t *pool);
+
+/**
+ * @brief Waits for pending work and stops all workers
+ */
+void pf_verify_pool_destroy(pf_verify_pool_t *pool);
+
+/* --------------- Ingest Pipeline ---------------*/
+#define PICOFEED_INGEST_DEPTH 256
+#define PICOFEED_MAX_BLOCK (16u << 20) /* ingest limit when dst has no max_size */
+
+/**
+ * Streams incoming bytes into a feed.
+ * The calling thread splits bytes into blocks, a pool of verifier
+ * threads checks signatures out of order and a committer thread
+ * appends verified blocks to the destination feed in height order.
+ * At most `depth` blocks are in flight, writers block when full.
+ */
+typedef struct pf_ingest_s pf_ingest_t;
+
+typedef struct {
+  size_t bytes_read;
+  size_t blocks_read;
+  size_t blocks_verified;
+  size_t blocks_committed;
+  size_t read_stalls;
+  uint64_t verify_ns;
+  uint64_t commit_ns;
+} pf_ingest_stats_t;
+
+/**
+ * @brief Starts an ingest pipeline
+ *
+ * The destination feed is owned by the pipeline
+ * until `pf_ingest_finish()` returns.
+ * The first ingested block must link to the last block of `dst`
+ * unless `dst` is empty.
+ *
+ * @param dst writable destination feed
+ * @param nthreads number of verifiers, 0 for one per online CPU
+ * @param depth max blocks in flight, 0 for PICOFEED_INGEST_DEPTH
+ * @return pipeline or NULL on error
+ */
+pf_ingest_t *pf_ingest_create(pico_feed_t *dst, int nthreads, size_t depth);
+
+/**
+ * @brief Feeds bytes into the pipeline
+ *
+ * Accepts arbitrary chunks of a feed or of concatenated blocks,
+ * a leading `PIC0` magic is skipped.
+ * Blocks claiming more than the destination's max_size
+ * (PICOFEED_MAX_BLOCK when unset) fail with EBOUNDS.
+ *
+ * @return 0 on success, < 0 when the pipeline failed
+ */
+int pf_ingest_write(pf_ingest_t *ing, const uint8_t *bytes, size_t len);
+
+/**
+ * @brief Drains the pipeline
+ * @return height of the destination feed or pf_decode_error_t
+ */
+int pf_ingest_finish(pf_ingest_t *ing);
+
+/**
+ * @brief Reads per-stage counters
+ */
+void pf_ingest_stats(pf_ingest_t *ing, pf_ingest_stats_t *stats);
+
+/**
+ * @brief Finishes and releases the pipeline
+ */
+void pf_ingest_destroy(pf_ingest_t *ing);
+
+/* --------------- Columnar Scan ---------------*/
+
+/* blocks per batch, keeps all columns within ~64KB of L2 */
+#ifndef PICOFEED_BATCH_SIZE
+#define PICOFEED_BATCH_SIZE 1024
+#endif
+
+/**
+ * Structure-of-arrays view over a run of blocks.
+ * Set `header` before decoding to collect its values into `value`.
+ */
+typedef struct {
+  pf_header_id_t header;  /* selected header id, 0 = none */
+  int count;              /* blocks in this batch */
+  size_t next;            /* offset after the last decoded block */
+  size_t offset[PICOFEED_BATCH_SIZE];
+  size_t len[PICOFEED_BATCH_SIZE];
+  const uint8_t *body[PICOFEED_BATCH_SIZE];
+  const uint8_t *author[PICOFEED_BATCH_SIZE];
+  const uint8_t *psig[PICOFEED_BATCH_SIZE];
+  const void *value[PICOFEED_BATCH_SIZE];
+} pf_columns_t;
+
+/**
+ * @brief Decodes up to `count` blocks into columns without verification
+ * @param start byte offset of the first block, 0 = head of feed
+ * @param count max blocks, clamped to PICOFEED_BATCH_SIZE
+ * @return number of blocks decoded, 0 at end of feed or pf_decode_error_t
+ *
+ * Pass `cols->next` as `start` to continue scanning.
+ * Signatures are not checked, use `pf_verify_from()` beforehand.
+ */
+int pf_decode_batch(const pico_feed_t *feed, size_t start, int count, pf_columns_t *cols);
+
+/* --------------- Predicate Scan ---------------*/
+
+/**
+ * Conditions a block must satisfy, unset fields match anything.
+ */
+typedef struct {
+  const uint8_t *author;        /* 32-byte public key */
+  pf_header_id_t header;        /* header that must be present, 0 = none */
+  const void *header_value;     /* compared over pf_header_size(header) bytes, NULL = any */
+  const uint8_t *body_prefix;
+  size_t body_prefix_len;
+  const uint8_t *pattern;       /* byte sequence anywhere in body */
+  size_t pattern_len;
+} pf_query_t;
+
+/**
+ * @brief Finds blocks matching query, verifying only the hits
+ *
+ * All blocks are parsed and their psig linkage checked,
+ * signatures are only verified for matching blocks.
+ *
+ * @param nthreads split the feed into this many block ranges, <= 1 scans inline
+ * @param matches receives offsets of matching blocks in feed order, may be NULL
+ * @param max_matches capacity of `matches`
+ * @return total number of matches (may exceed max_matches) or pf_decode_error_t
+ */
+int pf_scan(
+  const pico_feed_t *feed,
+  const pf_query_t *query,
+  int nthreads,
+  size_t *matches,
+  int max_matches
+);
+
+/* --------------- Fork Index ---------------*/
+
+/**
+ * Maps (author, psig) to the first child seen,
+ * a second child of the same parent is an equivocation.
+ * Genesis blocks are not indexed, an author may start many feeds.
+ */
+typedef struct pf_fork_index_s pf_fork_index_t;
+
+typedef struct {
+  pf_key_t author;
+  pf_signature_t parent;
+  pf_signature_t first;   /* first-seen child id */
+  pf_signature_t second;  /* conflicting child id */
+} pf_equivocation_t;
+
+/**
+ * @brief Creates an empty index
+ * @param capacity expected number of blocks, 0 for default
+ * @return index or NULL on allocation failure
+ */
+pf_fork_index_t *pf_fork_index_create(size_t capacity);
+
+/**
+ * @brief Records a single block
+ * @param out receives the conflict, may be NULL
+ * @return 1 on equivocation, 0 when consistent or < 0 on error
+ */
+int pf_fork_check(pf_fork_index_t *index, const pf_block_view_t *view, pf_equivocation_t *out);
+
+/**
+ * @brief Records all blocks of a feed
+ *
+ * Signatures are not checked, only index feeds that were verified
+ * on receive (`pf_ingest_*`) or with `pf_verify_from()`, whose
+ * skipped prefix is bound by a `pf_prefix_hash()` checkpoint.
+ *
+ * @param out receives up to max_out conflicts, may be NULL
+ * @return number of equivocations found or pf_decode_error_t
+ */
+int pf_fork_index_feed(pf_fork_index_t *index, const pico_feed_t *feed, pf_equivocation_t *out, int max_out);
+
+/**
+ * @brief Number of (author, parent) pairs recorded
+ */
+size_t pf_fork_index_size(const pf_fork_index_t *index);
+
+void pf_fork_index_destroy(pf_fork_index_t *index);
+
+/* --------------- Skip Links ---------------*/
+
+/**
+ * @brief Ancestor index linked by HDR_SKIP from block at `idx`
+ * @return ancestor index, idx - 1 when the block has no skip link
+ */
+int pf_skip_index(int idx);
+
+/**
+ * @brief Collects blocks linking the tip to block `k`
+ *
+ * The proof holds O(log n) blocks ordered from tip down to `k`,
+ * following HDR_SKIP where possible and HDR_PSIG otherwise.
+ * Source feed must start at genesis.
+ *
+ * @param proof initialized feed receiving the blocks
+ * @return number of blocks in proof or pf_decode_error_t,
+ *  EBOUNDS when the feed was sliced, shifted or capped,
+ *  EUNKHDR when a block on the path lacks HDR_SKIP
+ *  (feed not built with PF_FLAG_SKIP_LINKS)
+ */
+int pf_prove(const pico_feed_t *feed, int k, pico_feed_t *proof);
+
+/**
+ * @brief Checks that `proof` links a known tip to block `k`
+ * @param tip_id id of the trusted tip
+ * @param tip_idx index of the tip, genesis = 0
+ * @return 0 when valid or pf_decode_error_t
+ */
+int pf_verify_proof(const pico_feed_t *proof, const pf_signature_t tip_id, int tip_idx, int k);
+
+/* --------------- Offset Index ---------------*/
+
+/* smallest byte range handed to a boundary scanning thread */
+#ifndef PICOFEED_INDEX_MIN_CHUNK
+#define PICOFEED_INDEX_MIN_CHUNK 4096
+#endif
+
+typedef struct {
+  int len;
+  size_t *offsets; /* buffer offset of each block */
+} pf_index_t;
+
+/**
+ * @brief Locates all block boundaries using multiple threads
+ *
+ * Each thread guesses the first boundary within its byte range from
+ * the block shape and psig linkage, guesses are then stitched against
+ * the sequential chain so the result always equals a pf_next() walk.
+ * Signatures are not verified.
+ *
+ * @param index receives offsets, release with `pf_index_free()`
+ * @return number of blocks or pf_decode_error_t
+ */
+int pf_index_build(const pico_feed_t *feed, int nthreads, pf_index_t *index);
+
+void pf_index_free(pf_index_t *index);
+
+/* --------------- Sidecar Index ---------------*/
+
+/**
+ * On-disk block offsets for a feed file, stored next to it.
+ *
+ * Layout: `PIX0` magic, u64 block count, u64 covered feed size,
+ * 64-byte tip id, followed by pages of PICOFEED_SIDECAR_PAGE blocks.
+ * Each page holds a u64 base offset and one u32 delta per block.
+ * All integers are little endian.
+ */
+#define PICOFEED_SIDECAR_MAGIC "PIX0"
+#define PICOFEED_SIDECAR_HEADER (PICOFEED_MAGIC_SIZE + 8 + 8 + 64)
+#define PICOFEED_SIDECAR_PAGE 256
+#define PICOFEED_SIDECAR_PAGE_SIZE (8 + 4 * PICOFEED_SIDECAR_PAGE)
+
+typedef struct pf_sidecar_s pf_sidecar_t;
+
+/**
+ * @brief Creates or extends the sidecar of a feed file
+ *
+ * `feed` must hold the complete file contents (not shifted).
+ * Existing entries are kept when the stored tip is still part of
+ * the feed, only new blocks are written. Otherwise the file is rebuilt.
+ *
+ * @return number of indexed blocks or pf_decode_error_t
+ */
+int pf_sidecar_sync(const pico_feed_t *feed, const char *path);
+
+/**
+ * @brief Maps a sidecar read-only
+ * @param feed_fd when >= 0 the tip id is checked against the feed file
+ * @return sidecar or NULL when missing, corrupt or stale
+ */
+pf_sidecar_t *pf_sidecar_open(const char *path, int feed_fd);
+
+/**
+ * @brief Number of blocks in sidecar
+ */
+int pf_sidecar_len(const pf_sidecar_t *sidecar);
+
+/**
+ * @brief Location of a block in the feed file
+ * @param idx block index, negative wraps from end
+ * @param size receives block size, may be NULL
+ * @return file offset or pf_decode_error_t
+ */
+ssize_t pf_sidecar_offset(const pf_sidecar_t *sidecar, int idx, size_t *size);
+
+/**
+ * @brief Reads one block from a feed file with a single pread()
+ * @param dst receives the block, decode with `pf_decode_block()`
+ * @return block size or pf_decode_error_t, EBOUNDS when dst is too small
+ */
+ssize_t pf_file_get(int fd, const pf_sidecar_t *sidecar, int idx, uint8_t *dst, size_t dst_size);
+
+void pf_sidecar_close(pf_sidecar_t *sidecar);
+
+/* --------------- File Export ---------------*/
+
+/**
+ * @brief Maps a feed file read-only
+ *
+ * The feed ends after the last complete block in the file,
+ * appending is refused. Release with `pf_deinit()`.
+ *
+ * @param feed empty struct, do not pass an initialized feed
+ * @return number of blocks or pf_decode_error_t
+ */
+int pf_map(pico_feed_t *feed, int fd);
+
+/**
+ * @brief Sends a slice as a standalone feed without copying it
+ *
+ * Writes the `PIC0` magic followed by blocks [start_idx, end_idx)
+ * transferred with sendfile() straight from `feed_fd`.
+ *
+ * @param feed mirror of `feed_fd`, usually from `pf_map()`
+ * @param out_fd socket or file receiving the slice
+ * @param start_idx inclusive, negative wraps from end
+ * @param end_idx exclusive, negative wraps from end
+ * @return bytes written or pf_decode_error_t
+ */
+ssize_t pf_send(const pico_feed_t *feed, int feed_fd, int out_fd, int start_idx, int end_idx);
+
+/* --------------- Signing Service ---------------*/
+#define PICOFEED_SIGN_BATCH 64
+
+/**
+ * Appends to many feeds in parallel.
+ * Each feed is pinned to one worker so its blocks are signed in
+ * submission order, different feeds are signed concurrently.
+ * Workers take up to PICOFEED_SIGN_BATCH requests at a time
+ * and publish their completions together.
+ */
+typedef struct pf_signer_s pf_signer_t;
+
+typedef struct {
+  pico_feed_t *feed;
+  void *ctx;
+  /** new block height or < 0 on error */
+  int result;
+} pf_sign_completion_t;
+
+/**
+ * @brief Starts a pool of signing threads
+ * @param nthreads number of workers, 0 for one per online CPU
+ * @return signer or NULL on error
+ */
+pf_signer_t *pf_signer_create(int nthreads);
+
+/**
+ * @brief Queues a block for appending
+ *
+ * The body is copied, the feed is owned by the signer
+ * until the completion of its last request was polled.
+ *
+ * @param body application body, first byte must be non-zero
+ * @param ctx returned with the completion
+ * @return 0 when queued, < 0 on error
+ */
+int pf_signer_submit(
+  pf_signer_t *signer,
+  pico_feed_t *feed,
+  const uint8_t *body,
+  size_t body_len,
+  pf_keypair_t pair,
+  void *ctx
+);
+
+/**
+ * @brief Collects finished appends
+ * @param wait block until at least one completion is available
+ * or nothing is pending
+ * @return number of completions written to `out`
+ */
+int pf_signer_poll(pf_signer_t *signer, pf_sign_completion_t *out, int max, int wait);
+
+/**
+ * @brief Blocks until all submitted requests are signed
+ */
+void pf_signer_flush(pf_signer_t *signer);
+
+/**
+ * @brief Flushes and stops all workers,
+ * unpolled completions are discarded.
+ */
+void pf_signer_destroy(pf_signer_t *signer);
+
+/* --------------- Shared Cache ---------------*/
+#define PICOFEED_CACHE_SLOTS 1024
+
+/**
+ * Shares feed snapshots between processes.
+ * A directory of slots lives in a POSIX shared memory object,
+ * every published snapshot is its own object which readers
+ * map read-only with `pf_map()` semantics.
+ * Republishing a key bumps its generation and unlinks the previous
+ * snapshot, readers that still have it mapped keep a valid copy.
+ * On Linux the directory lock is robust, the next process taking it
+ * after a publisher crashed completes the interrupted publish and
+ * unlinks the snapshots it left behind. Elsewhere such a cache
+ * stays locked and must be removed with `pf_cache_unlink()`.
+ */
+typedef struct pf_cache_s pf_cache_t;
+
+/**
+ * @brief Opens or creates a cache
+ * @param name shm object name starting with '/'
+ * @param create non-zero to create the cache when missing
+ * @return cache or NULL on error
+ */
+pf_cache_t *pf_cache_open(const char *name, int create);
+
+/**
+ * @brief Publishes a snapshot of a feed
+ *
+ * The feed is copied as-is, publishers are expected to
+ * only share feeds they have verified.
+ *
+ * @param key feed identity, usually the author's public key
+ * @return new generation or < 0 on error
+ */
+int64_t pf_cache_publish(pf_cache_t *cache, const uint8_t key[32], const pico_feed_t *feed);
+
+/**
+ * @brief Maps the current snapshot of a key read-only
+ *
+ * The feed behaves like one opened with `pf_map()`
+ * and must be released with `pf_deinit()`.
+ *
+ * @param generation optional, receives the snapshot's generation
+ * @return feed height or EFAILED when the key is not cached
+ */
+int pf_cache_attach(pf_cache_t *cache, const uint8_t key[32], pico_feed_t *feed, uint64_t *generation);
+
+/**
+ * @brief Current generation of a key
+ * @return generation or 0 when the key is not cached
+ */
+uint64_t pf_cache_generation(pf_cache_t *cache, const uint8_t key[32]);
+
+/**
+ * @brief Closes the cache, attached feeds stay valid
+ */
+void pf_cache_close(pf_cache_t *cache);
+
+/**
+ * @brief Removes a cache and all of its snapshots
+ */
+int pf_cache_unlink(const char *name);
+
 #ifdef BENCH
 void dump_stats(void);
 #endif
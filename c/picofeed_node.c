@@ -0,0 +1,293 @@
+/* Node.js binding, exposes the C engine to index.js
+ * build: node-gyp rebuild -C c
+ */
+#include <node_api.h>
+#include <string.h>
+#include <stdlib.h>
+#include <monocypher.h>
+#include "picofeed.h"
+
+#define NAPI_CALL(env, call) do { \
+  if ((call) != napi_ok) { \
+    napi_throw_error((env), NULL, #call " failed"); \
+    return NULL; \
+  } \
+} while (0)
+
+static const char *
+error_name(int err) {
+  switch (err) {
+    case EUNKHDR: return "EUNKHDR";
+    case EDUPHDR: return "EDUPHDR";
+    case EVERFAIL: return "EVERFAIL";
+    case EBOUNDS: return "EBOUNDS";
+    case EPARENT: return "EPARENT";
+    default: return "EFAILED";
+  }
+}
+
+static napi_value
+throw_code(napi_env env, int err, const char *msg) {
+  napi_throw_error(env, error_name(err), msg);
+  return NULL;
+}
+
+/* reads a Uint8Array argument, NULL bytes when undefined or null */
+static int
+get_bytes(napi_env env, napi_value value, uint8_t **bytes, size_t *len) {
+  napi_valuetype type;
+  napi_typedarray_type ta_type;
+  int is_ta = 0;
+  bool flag = false;
+
+  *bytes = NULL;
+  *len = 0;
+  if (napi_ok != napi_typeof(env, value, &type)) return -1;
+  if (type == napi_undefined || type == napi_null) return 0;
+  if (napi_ok == napi_is_typedarray(env, value, &flag)) is_ta = flag;
+  if (!is_ta) return -1;
+  if (napi_ok != napi_get_typedarray_info(env, value, &ta_type, len, (void **)bytes, NULL, NULL)) return -1;
+  return ta_type == napi_uint8_array ? 0 : -1;
+}
+
+static napi_value
+new_bytes(napi_env env, const uint8_t *src, size_t len) {
+  napi_value buffer, array;
+  void *data = NULL;
+  NAPI_CALL(env, napi_create_arraybuffer(env, len, &data, &buffer));
+  if (len) memcpy(data, src, len);
+  NAPI_CALL(env, napi_create_typedarray(env, napi_uint8_array, len, buffer, 0, &array));
+  return array;
+}
+
+/* read-only feed over JS memory, never pf_deinit() it */
+static int
+borrow_feed(pico_feed_t *feed, uint8_t *bytes, size_t len) {
+  if (bytes == NULL || len < PICOFEED_MAGIC_SIZE || memcmp(bytes, PiC0, PICOFEED_MAGIC_SIZE)) return -1;
+  memset(feed, 0, sizeof(*feed));
+  feed->buffer = bytes;
+  feed->capacity = len;
+  feed->head = PICOFEED_MAGIC_SIZE;
+  feed->tail = len;
+  feed->flags = PF_FLAG_MAPPED;
+  return 0;
+}
+
+/* the public key is always derived, a caller supplied one
+ * would let mismatched pairs leak the secret through the nonce */
+static int
+get_keypair(napi_env env, napi_value seed, pf_keypair_t *pair) {
+  uint8_t *bytes;
+  size_t len;
+
+  memset(pair, 0, sizeof(*pair));
+  if (get_bytes(env, seed, &bytes, &len) || len != 32) return -1;
+  memcpy(pair->seed, bytes, 32);
+  pico_public_from_secret(pair->pk, pair->seed);
+  return 0;
+}
+
+/* publicKey(seed) => pk */
+static napi_value
+js_public_key(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value argv[1];
+  pf_keypair_t pair;
+  NAPI_CALL(env, napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  if (argc < 1 || get_keypair(env, argv[0], &pair)) return throw_code(env, EFAILED, "expected 32 byte seed");
+  crypto_wipe(pair.seed, sizeof(pair.seed));
+  return new_bytes(env, pair.pk, sizeof(pair.pk));
+}
+
+/* sign(message, seed) => signature */
+static napi_value
+js_sign(napi_env env, napi_callback_info info) {
+  size_t argc = 2;
+  napi_value argv[2];
+  pf_keypair_t pair;
+  pf_signature_t sig;
+  uint8_t *message;
+  size_t len;
+
+  NAPI_CALL(env, napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  if (argc < 2 || get_bytes(env, argv[0], &message, &len)) return throw_code(env, EFAILED, "expected message");
+  if (get_keypair(env, argv[1], &pair)) return throw_code(env, EFAILED, "expected 32 byte seed");
+  pico_crypto_sign(sig, message, len, pair);
+  crypto_wipe(&pair, sizeof(pair));
+  return new_bytes(env, sig, sizeof(sig));
+}
+
+/* verify(bytes, offset, psig?) => number of valid linked blocks from offset */
+static napi_value
+js_verify(napi_env env, napi_callback_info info) {
+  size_t argc = 3;
+  napi_value argv[3];
+  napi_value result;
+  uint8_t *bytes, *psig;
+  size_t len, psig_len;
+  int64_t start = 0;
+  int count = 0;
+
+  NAPI_CALL(env, napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  if (argc < 2 || get_bytes(env, argv[0], &bytes, &len)) return throw_code(env, EFAILED, "expected Uint8Array");
+  NAPI_CALL(env, napi_get_value_int64(env, argv[1], &start));
+  if (argc < 3 || get_bytes(env, argv[2], &psig, &psig_len)) psig = NULL;
+  if (psig != NULL && psig_len != sizeof(pf_signature_t)) return throw_code(env, EFAILED, "expected 64 byte psig");
+  if (start < 0 || (size_t)start > len) return throw_code(env, EBOUNDS, "offset out of bounds");
+
+  size_t o = (size_t)start;
+  const uint8_t *prev = psig;
+  while (len - o >= sizeof(pf_signature_t) + 2 && bytes[o + sizeof(pf_signature_t)]) {
+    pf_block_view_t view;
+    ssize_t size = pf_next_block_offset(bytes + o);
+    if (size <= 0 || (size_t)size > len - o) break;
+    if (pf_decode_view(bytes + o, &view, 0) != size) break;
+    if (prev != NULL && (view.psig == NULL || memcmp(view.psig, prev, sizeof(pf_signature_t)))) break;
+    prev = bytes + o;
+    o += (size_t)size;
+    ++count;
+  }
+
+  NAPI_CALL(env, napi_create_int32(env, count, &result));
+  return result;
+}
+
+static napi_value
+set_int(napi_env env, napi_value obj, const char *key, int64_t value) {
+  napi_value v;
+  NAPI_CALL(env, napi_create_int64(env, (int64_t)value, &v));
+  NAPI_CALL(env, napi_set_named_property(env, obj, key, v));
+  return obj;
+}
+
+/* decode(block, noVerify?) => { blockSize, bodyStart, bodyEnd, author, psig } offsets, -1 when absent */
+static napi_value
+js_decode(napi_env env, napi_callback_info info) {
+  size_t argc = 2;
+  napi_value argv[2];
+  napi_value obj;
+  pf_block_view_t view;
+  uint8_t *bytes;
+  size_t len;
+  bool no_verify = false;
+
+  NAPI_CALL(env, napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  if (argc < 1 || get_bytes(env, argv[0], &bytes, &len)) return throw_code(env, EFAILED, "expected Uint8Array");
+  if (argc > 1) napi_get_value_bool(env, argv[1], &no_verify);
+
+  ssize_t size = len > sizeof(pf_signature_t) + 2 ? pf_next_block_offset(bytes) : -1;
+  if (size <= 0 || (size_t)size > len) return throw_code(env, EBOUNDS, "BufferUnderflow");
+  int err = pf_decode_view(bytes, &view, no_verify);
+  if (err < 0) return throw_code(env, err, "decode failed");
+
+  NAPI_CALL(env, napi_create_object(env, &obj));
+  if (!set_int(env, obj, "blockSize", (int64_t)view.block_size)) return NULL;
+  if (!set_int(env, obj, "bodyStart", view.body - bytes)) return NULL;
+  if (!set_int(env, obj, "bodyEnd", view.body - bytes + (int64_t)view.len)) return NULL;
+  if (!set_int(env, obj, "author", view.author ? view.author - bytes : -1)) return NULL;
+  if (!set_int(env, obj, "psig", view.psig ? view.psig - bytes : -1)) return NULL;
+  return obj;
+}
+
+/* append(feed, body, seed) => new feed bytes */
+static napi_value
+js_append(napi_env env, napi_callback_info info) {
+  size_t argc = 3;
+  napi_value argv[3];
+  napi_value result;
+  pico_feed_t src, dst = {0};
+  pf_keypair_t pair;
+  uint8_t *bytes, *body;
+  size_t len, body_len;
+
+  NAPI_CALL(env, napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  if (argc < 3 || get_bytes(env, argv[0], &bytes, &len) || borrow_feed(&src, bytes, len)) {
+    return throw_code(env, EFAILED, "expected feed bytes");
+  }
+  if (get_bytes(env, argv[1], &body, &body_len) || body == NULL) return throw_code(env, EFAILED, "expected body");
+  if (get_keypair(env, argv[2], &pair)) return throw_code(env, EFAILED, "expected 32 byte seed");
+
+  pf_clone(&dst, &src);
+  ssize_t err = pf_append(&dst, body, body_len, NULL, 0, pair);
+  crypto_wipe(&pair, sizeof(pair));
+  if (err < 0) {
+    pf_deinit(&dst);
+    return throw_code(env, (int)err, "append failed");
+  }
+  result = new_bytes(env, dst.buffer, dst.tail);
+  pf_deinit(&dst);
+  return result;
+}
+
+/* diff(a, b) => block count, throws 'unrelated' or 'diverged' */
+static napi_value
+js_diff(napi_env env, napi_callback_info info) {
+  size_t argc = 2;
+  napi_value argv[2];
+  napi_value result;
+  pico_feed_t a, b;
+  uint8_t *a_bytes, *b_bytes;
+  size_t a_len, b_len;
+  int out = 0;
+
+  NAPI_CALL(env, napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  if (
+    argc < 2 ||
+    get_bytes(env, argv[0], &a_bytes, &a_len) || borrow_feed(&a, a_bytes, a_len) ||
+    get_bytes(env, argv[1], &b_bytes, &b_len) || borrow_feed(&b, b_bytes, b_len)
+  ) return throw_code(env, EFAILED, "expected feed bytes");
+
+  switch (pf_diff(&a, &b, &out)) {
+    case UNRELATED: napi_throw_error(env, NULL, "unrelated"); return NULL;
+    case DIVERGED: napi_throw_error(env, NULL, "diverged"); return NULL;
+    default: break;
+  }
+  NAPI_CALL(env, napi_create_int32(env, out, &result));
+  return result;
+}
+
+/* slice(feed, start, end) => new feed bytes */
+static napi_value
+js_slice(napi_env env, napi_callback_info info) {
+  size_t argc = 3;
+  napi_value argv[3];
+  napi_value result;
+  pico_feed_t src, dst = {0};
+  uint8_t *bytes;
+  size_t len;
+  int32_t start = 0, end = 0;
+
+  NAPI_CALL(env, napi_get_cb_info(env, info, &argc, argv, NULL, NULL));
+  if (argc < 3 || get_bytes(env, argv[0], &bytes, &len) || borrow_feed(&src, bytes, len)) {
+    return throw_code(env, EFAILED, "expected feed bytes");
+  }
+  NAPI_CALL(env, napi_get_value_int32(env, argv[1], &start));
+  NAPI_CALL(env, napi_get_value_int32(env, argv[2], &end));
+
+  pf_init(&dst);
+  int err = pf_slice(&dst, &src, start, end);
+  if (err < 0) {
+    pf_deinit(&dst);
+    return throw_code(env, err, "slice failed");
+  }
+  result = new_bytes(env, dst.buffer, dst.tail);
+  pf_deinit(&dst);
+  return result;
+}
+
+static napi_value
+init(napi_env env, napi_value exports) {
+  const napi_property_descriptor props[] = {
+    { "publicKey", NULL, js_public_key, NULL, NULL, NULL, napi_enumerable, NULL },
+    { "sign", NULL, js_sign, NULL, NULL, NULL, napi_enumerable, NULL },
+    { "verify", NULL, js_verify, NULL, NULL, NULL, napi_enumerable, NULL },
+    { "decode", NULL, js_decode, NULL, NULL, NULL, napi_enumerable, NULL },
+    { "append", NULL, js_append, NULL, NULL, NULL, napi_enumerable, NULL },
+    { "diff", NULL, js_diff, NULL, NULL, NULL, napi_enumerable, NULL },
+    { "slice", NULL, js_slice, NULL, NULL, NULL, napi_enumerable, NULL }
+  };
+  NAPI_CALL(env, napi_define_properties(env, exports, sizeof(props) / sizeof(props[0]), props));
+  return exports;
+}
+
+NAPI_MODULE(NODE_GYP_MODULE_NAME, init)
@@ -5,9 +5,19 @@
 
 #include <assert.h>
 #include <ctype.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <dirent.h>
+#include <signal.h>
+#endif
 
 #include "log.h"
 
@@ -62,6 +72,24 @@ static const char JS_FEED_B0_B1_HEX[] =
   "17aa4695958601104d61792e00029e18cace6e020264ca63836eabb453696b35"
   "546b5e0a79ee1da05e52dccd5e2bfad7bb51c03be7ea2aabe47db06f97c707e9"
   "656acf8cb83a34528340ebe188054231";
+/* B0, B1, B2 with PF_FLAG_SKIP_LINKS, B2 carries HDR_SKIP to B0 */
+static const char JS_FEED_SKIP_HEX[] =
+  "504943309e18cace6e020264ca63836eabb453696b35546b5e0a79ee1da05e52"
+  "dccd5e2bfad7bb51c03be7ea2aabe47db06f97c707e9656acf8cb83a34528340"
+  "ebe188052400017f27cc492c272e24f1a1428dd528c9f089f36a3d17aa469595"
+  "8601104d61792e42302c64c8f442a8af65fbedad20ea15b50b60e5554d51ecdb"
+  "332c661fd708c1a74823fac5db71fe891d9de43ed2e2a3955e64efad5602fd15"
+  "303c42b768a2620d096600017f27cc492c272e24f1a1428dd528c9f089f36a3d"
+  "17aa4695958601104d61792e00029e18cace6e020264ca63836eabb453696b35"
+  "546b5e0a79ee1da05e52dccd5e2bfad7bb51c03be7ea2aabe47db06f97c707e9"
+  "656acf8cb83a34528340ebe1880542318d6597a0f4e96af51fb0092f36f25895"
+  "df8167c262a740f5a1c36eb53016fa5e3a790ef965bcca426226c60db6f72808"
+  "d328d6294acf21c3ffc714c6d7a1320ca80100017f27cc492c272e24f1a1428d"
+  "d528c9f089f36a3d17aa4695958601104d61792e00022c64c8f442a8af65fbed"
+  "ad20ea15b50b60e5554d51ecdb332c661fd708c1a74823fac5db71fe891d9de4"
+  "3ed2e2a3955e64efad5602fd15303c42b768a2620d09007f9e18cace6e020264"
+  "ca63836eabb453696b35546b5e0a79ee1da05e52dccd5e2bfad7bb51c03be7ea"
+  "2aabe47db06f97c707e9656acf8cb83a34528340ebe188054232";
 static const char JS_SLICE_ONE_TWO_HEX[] =
   "504943304335651a1f1974f0ccc841a47a0fa558ebb3e8c42a74e6b0c74c82cd"
   "d358244e6f89811c6ed91c7d8ebe9af46aa0c50cde0fd9f49e9eb3314176481d"
@@ -471,6 +499,16 @@ test_js_v8_feed_bytes(void) {
   assert_buffer_equals_hex(feed.buffer, feed.tail, JS_FEED_B0_B1_HEX);
   OK(1, "native append matches JS feed bytes");
 
+  pf_block_t block = {0};
+  pf_truncate(&feed, 0);
+  feed.flags |= PF_FLAG_SKIP_LINKS;
+  APPEND0(&feed, "B0", 2, pair);
+  APPEND0(&feed, "B1", 2, pair);
+  APPEND0(&feed, "B2", 2, pair);
+  assert_buffer_equals_hex(feed.buffer, feed.tail, JS_FEED_SKIP_HEX);
+  assert(0 == pf_get(&feed, &block, 2));
+  OK(pf_block_header(&block, HDR_SKIP) != NULL, "skip link vector matches JS");
+
   pf_deinit(&feed);
   return 0;
 }
@@ -527,6 +565,1548 @@ test_js_v8_slice_and_truncate(void) {
   return 0;
 }
 
+static int
+test_pop0201_verify_from(void) {
+  pf_keypair_t pair = {0};
+  pico_crypto_keypair(&pair);
+
+  pico_feed_t feed = {0};
+  pf_block_t checkpoint = {0};
+  pf_block_t block = {0};
+  char msg[16];
+
+  pf_init(&feed);
+  for (int i = 0; i < 10; i++) {
+    sprintf(msg, "block%i", i);
+    APPEND0(&feed, msg, strlen(msg), pair);
+  }
+
+  uint8_t prefix[32];
+  assert(0 == pf_get(&feed, &checkpoint, 6));
+  assert(0 == pf_prefix_hash(&feed, 7, prefix));
+  OK(10 == pf_verify_from(&feed, 0, NULL, NULL), "full verification");
+  OK(10 == pf_verify_from(&feed, 7, checkpoint.id, prefix), "verified from checkpoint");
+  OK(EVERFAIL == pf_verify_from(&feed, 6, checkpoint.id, prefix), "checkpoint id mismatch");
+  OK(EBOUNDS == pf_verify_from(&feed, 11, checkpoint.id, prefix), "checkpoint beyond tip");
+  OK(EFAILED == pf_verify_from(&feed, 7, checkpoint.id, NULL), "prefix hash required");
+  OK(EBOUNDS == pf_prefix_hash(&feed, 11, prefix), "prefix beyond tip");
+
+  assert(0 == pf_get(&feed, &block, 3));
+  ((uint8_t *)block.body)[0] = 'B';
+  OK(EVERFAIL == pf_verify_from(&feed, 7, checkpoint.id, prefix), "tampered prefix fails hash");
+  OK(EVERFAIL == pf_verify_from(&feed, 0, NULL, NULL), "tampered prefix fails full verification");
+  ((uint8_t *)block.body)[0] = 'b';
+
+  ((uint8_t *)checkpoint.body)[0] = 'B';
+  OK(EVERFAIL == pf_verify_from(&feed, 7, checkpoint.id, prefix), "checkpoint signature verified");
+  ((uint8_t *)checkpoint.body)[0] = 'b';
+
+  assert(0 == pf_get(&feed, &block, 8));
+  ((uint8_t *)block.body)[0] = 'B';
+  OK(EVERFAIL == pf_verify_from(&feed, 7, checkpoint.id, prefix), "blocks above checkpoint verified");
+  ((uint8_t *)block.body)[0] = 'b';
+
+  assert(0 == pf_get(&feed, &block, 5));
+  ((uint8_t *)pf_block_header(&block, HDR_PSIG))[0] ^= 0xff;
+  OK(EPARENT == pf_verify_from(&feed, 7, checkpoint.id, prefix), "broken linkage detected");
+
+  pf_deinit(&feed);
+  return 0;
+}
+
+static int
+test_pop0201_watermark(void) {
+  pf_keypair_t pair = {0};
+  pico_crypto_keypair(&pair);
+
+  char path[] = "/tmp/picofeed_test_XXXXXX";
+  const int tmp_fd = mkstemp(path);
+  assert(tmp_fd >= 0);
+  close(tmp_fd);
+  const uint8_t key[32] = { 0x13, 0x37 };
+  const uint8_t wrong_key[32] = { 0x42 };
+  pico_feed_t feed = {0};
+  pf_watermark_t wm = {0};
+  pf_watermark_t loaded = {0};
+  pf_block_t block = {0};
+  char msg[16];
+
+  pf_init(&feed);
+  for (int i = 0; i < 8; i++) {
+    sprintf(msg, "block%i", i);
+    APPEND0(&feed, msg, strlen(msg), pair);
+  }
+
+  OK(0 == pf_watermark(&feed, &wm, key), "watermark recorded");
+  OK(0 == pf_watermark_save(&wm, path), "watermark saved");
+  OK(0 == pf_watermark_load(&loaded, path), "watermark loaded");
+  OK(0 == memcmp(&wm, &loaded, sizeof(wm)), "watermark survives roundtrip");
+  OK(loaded.height == 8 && loaded.size == feed.tail - PICOFEED_MAGIC_SIZE, "height and size recorded");
+
+  APPEND0(&feed, "block8", 6, pair);
+  APPEND0(&feed, "block9", 6, pair);
+  OK(10 == pf_verify_watermark(&feed, &loaded, key), "appended blocks verified");
+  OK(EVERFAIL == pf_verify_watermark(&feed, &loaded, wrong_key), "checksum is keyed");
+
+  assert(0 == pf_get(&feed, &block, 2));
+  ((uint8_t *)block.body)[0] = 'B';
+  OK(EVERFAIL == pf_verify_watermark(&feed, &loaded, key), "tampered prefix detected");
+  ((uint8_t *)block.body)[0] = 'b';
+
+  pf_shift(&feed, 1);
+  OK(EVERFAIL == pf_verify_watermark(&feed, &loaded, key), "shifted feed rejected");
+  OK(0 == pf_watermark(&feed, &wm, key) && 9 == wm.height, "watermark of shifted feed");
+  APPEND0(&feed, "block10", 7, pair);
+  OK(10 == pf_verify_watermark(&feed, &wm, key), "verified from shifted head");
+
+  pf_truncate(&feed, 4);
+  OK(EBOUNDS == pf_verify_watermark(&feed, &wm, key), "truncated feed rejected");
+
+  remove(path);
+  OK(0 > pf_watermark_load(&loaded, path), "missing sidecar reported");
+  pf_deinit(&feed);
+  return 0;
+}
+
+static int
+test_pop0201_digest(void) {
+  pf_keypair_t pair = {0};
+  pico_crypto_keypair(&pair);
+
+  pico_feed_t a = {0};
+  pico_feed_t b = {0};
+  pico_feed_t c = {0};
+  pico_feed_t empty = {0};
+  uint8_t d_a[PICOFEED_DIGEST_SIZE];
+  uint8_t d_b[PICOFEED_DIGEST_SIZE];
+  uint8_t d_zero[PICOFEED_DIGEST_SIZE] = {0};
+  char msg[16];
+
+  pf_init(&a);
+  pf_init(&empty);
+  for (int i = 0; i < 40; i++) {
+    sprintf(msg, "block%i", i);
+    APPEND0(&a, msg, strlen(msg), pair);
+  }
+
+  OK(0 == pf_digest(&empty, d_a) && 0 == memcmp(d_a, d_zero, sizeof(d_a)), "empty feed digest is zero");
+  OK(40 == pf_digest(&a, d_a), "digest returns height");
+
+  pf_clone(&b, &a);
+  OK(pf_equal(&a, &b), "clone is equal");
+  OK(!pf_equal(&a, &empty), "empty feed differs");
+
+  APPEND0(&a, "fourty", 6, pair);
+  OK(!pf_equal(&a, &b), "append updates digest");
+  OK(0 == pf_digest_at(&a, 40, d_a) && 40 == pf_digest(&b, d_b), "content address at height");
+  OK(0 == memcmp(d_a, d_b, sizeof(d_a)), "prefix digest matches shorter replica");
+  OK(EBOUNDS == pf_digest_at(&a, 42, d_a), "height beyond tip rejected");
+
+  APPEND0(&b, "fourty", 6, pair);
+  OK(pf_equal(&a, &b), "replicas converge");
+
+  pf_truncate(&a, 12);
+  OK(0 == pf_digest_at(&b, 12, d_b) && 12 == pf_digest(&a, d_a), "truncate rewinds digest");
+  OK(0 == memcmp(d_a, d_b, sizeof(d_a)), "truncated digest matches checkpoint");
+  APPEND0(&a, "other", 5, pair);
+  OK(0 == pf_digest_at(&b, 13, d_b) && 13 == pf_digest(&a, d_a), "reappend extends digest");
+  OK(0 != memcmp(d_a, d_b, sizeof(d_a)), "diverged block changes digest");
+
+  pf_slice(&c, &b, 0, 12);
+  pf_truncate(&a, 12);
+  OK(pf_equal(&a, &c), "slice from genesis equals truncated feed");
+  pf_slice(&c, &b, 1, 13);
+  OK(!pf_equal(&a, &c), "shifted slice differs");
+
+  pf_deinit(&empty);
+  pf_deinit(&c);
+  pf_deinit(&b);
+  pf_deinit(&a);
+  return 0;
+}
+
+static int
+test_pop0201_shift(void) {
+  pf_keypair_t pair = {0};
+  pico_crypto_keypair(&pair);
+
+  pico_feed_t feed = {0};
+  pico_feed_t full = {0};
+  pico_feed_t clone = {0};
+  pf_block_t block = {0};
+  int diff = 0;
+  char msg[16];
+
+  pf_init(&feed);
+  pf_init(&full);
+  for (int i = 0; i < 10; i++) {
+    sprintf(msg, "block%i", i);
+    APPEND0(&feed, msg, strlen(msg), pair);
+    APPEND0(&full, msg, strlen(msg), pair);
+  }
+  pf_deinit(&full);
+  pf_clone(&full, &feed);
+
+  const size_t tail = feed.tail;
+  OK(3 == pf_shift(&feed, 3), "3 blocks dropped");
+  OK(tail == feed.tail && feed.head > PICOFEED_MAGIC_SIZE, "shift does not move memory");
+  OK(7 == pf_len(&feed), "length honors head");
+  OK(0 == pf_get(&feed, &block, 0) && expect_body(&block, "block3"), "first block after shift");
+  OK(0 == pf_get(&feed, &block, -1) && expect_body(&block, "block9"), "last block after shift");
+  OK(7 == pf_verify_from(&feed, 0, NULL, NULL), "shifted feed verifies");
+  OK(OK == pf_diff(&full, &feed, &diff) && diff == 0, "full feed diff shifted feed is 0");
+
+  OK(11 == pf_append(&full, (const uint8_t *)"block10", 7, NULL, 0, pair), "full feed appended");
+  OK(8 == APPEND0(&feed, "block10", 7, pair), "append after shift");
+  OK(OK == pf_diff(&full, &feed, &diff) && diff == 0, "appended blocks identical");
+
+  pf_clone(&clone, &feed);
+  OK(clone.head == PICOFEED_MAGIC_SIZE && 8 == pf_len(&clone), "clone is compacted");
+  OK(pf_equal(&clone, &feed), "clone equals shifted feed");
+
+  OK(8 == pf_shift(&feed, 100), "shift beyond tip empties feed");
+  OK(0 == pf_len(&feed) && feed.tail == PICOFEED_MAGIC_SIZE, "empty feed is reset");
+
+  pf_deinit(&clone);
+  pf_deinit(&full);
+  pf_deinit(&feed);
+  return 0;
+}
+
+static int
+test_pop0201_capped_feed(void) {
+  pf_keypair_t pair = {0};
+  pico_crypto_keypair(&pair);
+
+  const size_t max_size = 1024;
+  pico_feed_t feed = {0};
+  pico_feed_t window = {0};
+  pf_block_t block = {0};
+  uint8_t d_feed[PICOFEED_DIGEST_SIZE];
+  uint8_t d_window[PICOFEED_DIGEST_SIZE];
+  char msg[16];
+
+  pf_init(&feed);
+  pf_set_max_size(&feed, max_size);
+  pf_digest(&feed, d_feed);
+
+  for (int i = 0; i < 500; i++) {
+    sprintf(msg, "block%03i", i);
+    assert(APPEND0(&feed, msg, strlen(msg), pair) > 0);
+    assert(feed.tail - feed.head <= max_size);
+  }
+  OK(feed.capacity <= 2 * (max_size + PICOFEED_MAGIC_SIZE), "capped feed does not grow");
+  OK(0 == pf_last(&feed, &block) && expect_body(&block, "block499"), "latest block retained");
+  OK(0 == pf_get(&feed, &block, 0) && expect_body(&block, "block495"), "oldest blocks dropped");
+  OK(pf_len(&feed) == pf_verify_from(&feed, 0, NULL, NULL), "capped feed verifies");
+
+  pf_slice(&window, &feed, 0, pf_len(&feed));
+  OK(pf_len(&feed) == pf_digest(&feed, d_feed), "capped digest covers the window");
+  OK(pf_len(&feed) == pf_digest(&window, d_window) && 0 == memcmp(d_feed, d_window, sizeof(d_feed)), "capped digest matches its slice");
+  pf_deinit(&window);
+
+  uint8_t *large = malloc(max_size);
+  memset(large, 'x', max_size);
+  OK(EBOUNDS == APPEND0(&feed, large, max_size, pair), "oversized block rejected");
+  free(large);
+
+  pf_deinit(&feed);
+  return 0;
+}
+
+static int
+test_pop0201_inline_feed(void) {
+  pf_keypair_t pair = {0};
+  pico_crypto_keypair(&pair);
+
+  pico_feed_t feed = {0};
+  pico_feed_t small = {0};
+  pico_feed_t large = {0};
+  char msg[16];
+
+  pf_init(&feed);
+  OK(feed.buffer == feed.inline_buffer, "new feed uses inline storage");
+  OK(1 == APPEND0(&feed, "tiny", 4, pair), "tiny block appended");
+  OK(feed.buffer == feed.inline_buffer, "one-block feed stays inline");
+
+  pf_clone(&small, &feed);
+  OK(small.buffer == small.inline_buffer, "small clone stays inline");
+  OK(pf_equal(&small, &feed), "inline clone is equal");
+
+  for (int i = 0; i < 20; i++) {
+    sprintf(msg, "block%i", i);
+    APPEND0(&feed, msg, strlen(msg), pair);
+  }
+  OK(feed.buffer != feed.inline_buffer, "outgrown feed moved to heap");
+  OK(21 == pf_verify_from(&feed, 0, NULL, NULL), "moved feed intact");
+  OK(feed.capacity - feed.tail >= feed.block_hint, "growth leaves room for another block");
+
+  pf_clone(&large, &feed);
+  OK(large.capacity > large.tail, "clone leaves room for next append");
+  const size_t capacity = large.capacity;
+  APPEND0(&large, "block20", 7, pair);
+  OK(capacity == large.capacity, "first append after clone does not grow");
+
+  /* no appends observed yet */
+  pf_deinit(&large);
+  feed.block_hint = 0;
+  pf_clone(&large, &feed);
+  OK(large.capacity > large.tail, "clone without block hint leaves headroom");
+
+  pf_deinit(&large);
+  pf_deinit(&small);
+  pf_deinit(&feed);
+  return 0;
+}
+
+typedef struct {
+  const pico_feed_t *feed;
+  int result;
+  int calls;
+  pthread_t thread;
+} verify_result_t;
+
+static void
+on_verified(const pico_feed_t *feed, int result, void *ctx) {
+  verify_result_t *res = ctx;
+  res->feed = feed;
+  res->result = result;
+  res->calls++;
+  res->thread = pthread_self();
+}
+
+static int
+test_pop0201_verify_pool(void) {
+  pf_keypair_t pair = {0};
+  pico_crypto_keypair(&pair);
+
+#define NFEEDS 24
+  pico_feed_t feeds[NFEEDS];
+  verify_result_t results[NFEEDS];
+  pf_verify_pool_t *pool = NULL;
+  pf_block_t block = {0};
+  char msg[16];
+
+  memset(results, 0, sizeof(results));
+  for (int f = 0; f < NFEEDS; f++) {
+    pf_init(&feeds[f]);
+    /* skewed sizes, a few large feeds and many small ones */
+    const int len = f % 8 == 0 ? 140 + f : 1 + f % 5;
+    for (int i = 0; i < len; i++) {
+      sprintf(msg, "f%ib%i", f, i);
+      APPEND0(&feeds[f], msg, strlen(msg), pair);
+    }
+  }
+
+  assert(0 == pf_get(&feeds[8], &block, 100));
+  ((uint8_t *)block.body)[0] = 'F';
+  const pf_header_t forged[] = { { HDR_PSIG, ZERO_SIG } };
+  assert(0 < pf_append(&feeds[16], (const uint8_t *)"forged", 6, forged, 1, pair));
+
+  pool = pf_verify_pool_create(4);
+  OK(pool != NULL, "pool started");
+  MEASURE("pool verify",
+    for (int f = 0; f < NFEEDS; f++) {
+      assert(0 == pf_verify_pool_submit(pool, &feeds[f], on_verified, &results[f]));
+    }
+    pf_verify_pool_wait(pool);
+  );
+
+  int ok = 1;
+  for (int f = 0; f < NFEEDS; f++) {
+    if (f == 8 || f == 16) continue;
+    ok &= results[f].calls == 1 && results[f].feed == &feeds[f] && results[f].result == pf_len(&feeds[f]);
+  }
+  OK(ok, "every feed reported its height");
+  OK(results[8].result == EVERFAIL, "tampered block detected");
+  OK(results[16].result == EPARENT, "broken linkage detected");
+
+  pico_feed_t empty = {0};
+  verify_result_t empty_result = {0};
+  pf_init(&empty);
+  assert(0 == pf_verify_pool_submit(pool, &empty, on_verified, &empty_result));
+  pf_verify_pool_wait(pool);
+  OK(empty_result.calls == 1 && empty_result.result == 0, "empty feed reported");
+  OK(!pthread_equal(empty_result.thread, pthread_self()), "empty feed reported from a worker");
+  pf_deinit(&empty);
+
+  ((uint8_t *)block.body)[0] = 'f';
+  assert(0 == pf_verify_pool_submit(pool, &feeds[8], on_verified, &results[8]));
+  pf_verify_pool_destroy(pool);
+  OK(results[8].result == pf_len(&feeds[8]), "resubmitted feed verified before shutdown");
+
+  for (int f = 0; f < NFEEDS; f++) pf_deinit(&feeds[f]);
+#undef NFEEDS
+  return 0;
+}
+
+static int
+test_pop0201_ingest(void) {
+  pf_keypair_t pair = {0};
+  pico_crypto_keypair(&pair);
+
+  pico_feed_t src = {0};
+  pico_feed_t dst = {0};
+  pico_feed_t bad = {0};
+  pf_ingest_stats_t stats = {0};
+  pf_block_t block = {0};
+  char msg[16];
+
+  pf_init(&src);
+  for (int i = 0; i < 120; i++) {
+    sprintf(msg, "block%i", i);
+    APPEND0(&src, msg, strlen(msg), pair);
+  }
+
+  /* odd chunk sizes split blocks, magic and varints */
+  pf_init(&dst);
+  pf_ingest_t *ing = pf_ingest_create(&dst, 3, 8);
+  OK(ing != NULL, "pipeline started");
+  MEASURE("pipelined ingest",
+    for (size_t o = 0; o < src.tail; o += 37) {
+      const size_t n = src.tail - o < 37 ? src.tail - o : 37;
+      assert(0 == pf_ingest_write(ing, src.buffer + o, n));
+    }
+    OK(120 == pf_ingest_finish(ing), "all blocks committed");
+  );
+  pf_ingest_stats(ing, &stats);
+  pf_ingest_destroy(ing);
+  OK(stats.bytes_read == src.tail, "reader counted bytes");
+  OK(stats.blocks_read == 120 && stats.blocks_verified == 120 && stats.blocks_committed == 120, "stage counters");
+  OK(src.tail == dst.tail && 0 == memcmp(src.buffer, dst.buffer, src.tail), "committed in height order");
+
+  /* continue an existing feed */
+  APPEND0(&src, "block120", 8, pair);
+  APPEND0(&src, "block121", 8, pair);
+  const size_t offset = dst.tail;
+  ing = pf_ingest_create(&dst, 2, 0);
+  assert(0 == pf_ingest_write(ing, src.buffer + offset, src.tail - offset));
+  OK(122 == pf_ingest_finish(ing), "ingest extends destination");
+  pf_ingest_destroy(ing);
+
+  /* tampered block stops the pipeline */
+  assert(0 == pf_get(&src, &block, 60));
+  ((uint8_t *)block.body)[0] = 'B';
+  pf_init(&bad);
+  ing = pf_ingest_create(&bad, 2, 4);
+  pf_ingest_write(ing, src.buffer, src.tail);
+  OK(EVERFAIL == pf_ingest_finish(ing), "verification failure reported");
+  OK(60 == pf_len(&bad), "blocks before failure committed");
+  pf_ingest_destroy(ing);
+  ((uint8_t *)block.body)[0] = 'b';
+
+  /* unrelated blocks are not appended */
+  pf_truncate(&bad, 10);
+  ing = pf_ingest_create(&bad, 2, 4);
+  pf_ingest_write(ing, src.buffer + offset, src.tail - offset);
+  OK(EPARENT == pf_ingest_finish(ing), "unlinked block rejected");
+  pf_ingest_destroy(ing);
+
+  ing = pf_ingest_create(&bad, 1, 4);
+  pf_ingest_write(ing, src.buffer + offset, 100);
+  OK(EFAILED == pf_ingest_finish(ing), "truncated input reported");
+  pf_ingest_destroy(ing);
+
+  /* a block claiming 1GB is refused before it is buffered */
+  uint8_t huge[64 + 5] = {0};
+  memcpy(huge + 64, "\x80\x80\x80\x80\x04", 5);
+  ing = pf_ingest_create(&bad, 1, 4);
+  OK(EBOUNDS == pf_ingest_write(ing, huge, sizeof(huge)), "oversized block refused");
+  OK(EBOUNDS == pf_ingest_finish(ing), "oversized block reported");
+  pf_ingest_destroy(ing);
+
+  pf_deinit(&bad);
+  pf_deinit(&dst);
+  pf_deinit(&src);
+  return 0;
+}
+
+static int
+test_pop02_iov_block(void) {
+  pf_keypair_t pair = {0};
+  pf_block_t block = {0};
+  pf_signature_t psig = {0};
+  const pf_header_t headers[] = {
+    { .id = HDR_AUTHOR },
+    { .id = HDR_PSIG, .value = psig },
+  };
+  const size_t body_len = 3 * 1024 * 1024 + 7;
+  uint8_t *body = malloc(body_len);
+  uint8_t *contiguous;
+  uint8_t prefix[256];
+  struct iovec chunks[37];
+  struct iovec parts[40];
+  size_t o = 0;
+  ssize_t size, prefix_size;
+  int n = 0;
+
+  assert(body != NULL);
+  pico_crypto_keypair(&pair);
+  pico_crypto_random(psig, sizeof(psig));
+  for (size_t i = 0; i < body_len; ++i) body[i] = (uint8_t)('a' + i % 26);
+
+  /* uneven chunks, including an empty one */
+  for (int i = 0; i < 37; ++i) {
+    size_t len = i == 36 ? body_len - o : (i == 3 ? 0 : 4093 * (size_t)(i + 1));
+    chunks[i].iov_base = body + o;
+    chunks[i].iov_len = len;
+    o += len;
+  }
+  assert(o == body_len);
+
+  size = pf_sizeof(body_len, headers, 2);
+  contiguous = malloc((size_t)size);
+  assert(contiguous != NULL);
+  assert(size == pf_create_block(contiguous, body, body_len, headers, 2, pair));
+
+  MEASURE("iov create",
+    prefix_size = pf_create_block_iov(prefix, chunks, 37, headers, 2, pair));
+  OK(prefix_size == size - (ssize_t)body_len, "only prefix written");
+  OK(0 == memcmp(prefix, contiguous, (size_t)prefix_size), "prefix identical to contiguous block");
+
+  OK(size == pf_decode_block(contiguous, &block, 0), "contiguous block verifies");
+  OK(0 == memcmp(*block_psig(&block), psig, sizeof(psig)), "psig retained");
+
+  /* split the prefix at odd offsets */
+  parts[n++] = (struct iovec){ prefix, 13 };
+  parts[n++] = (struct iovec){ prefix + 13, 64 };
+  parts[n++] = (struct iovec){ prefix + 77, (size_t)prefix_size - 77 };
+  for (int i = 0; i < 37; ++i) parts[n++] = chunks[i];
+  MEASURE("iov verify", size = pf_verify_block_iov(parts, n));
+  OK(size == (ssize_t)(body_len + (size_t)prefix_size), "split block verifies");
+
+  /* tampered body */
+  body[body_len / 2] ^= 1;
+  OK(EVERFAIL == pf_verify_block_iov(parts, n), "tampered body rejected");
+  body[body_len / 2] ^= 1;
+
+  OK(EFAILED == pf_verify_block_iov(parts, n - 1), "short block rejected");
+
+  const pf_header_t duplicate[] = { { HDR_PSIG, psig }, { HDR_PSIG, psig } };
+  OK(EDUPHDR == pf_create_block_iov(prefix, chunks, 37, duplicate, 2, pair), "header error propagated");
+
+  body[0] = 0;
+  OK(EFAILED == pf_create_block_iov(prefix, chunks, 37, headers, 2, pair), "zero body prefix rejected");
+
+  free(contiguous);
+  free(body);
+  return 0;
+}
+
+static int
+test_pop02_canonical_decode(void) {
+  pf_keypair_t pair = {0};
+  pf_block_t block = {0};
+  pf_signature_t psig = {0};
+  const pf_header_t canonical[] = {
+    { .id = HDR_AUTHOR },
+    { .id = HDR_PSIG, .value = psig },
+  };
+  const pf_header_t reordered[] = {
+    { .id = HDR_PSIG, .value = psig },
+    { .id = HDR_AUTHOR },
+  };
+  const char body[] = "canonical body";
+  uint8_t a[256], b[256];
+  ssize_t a_size, b_size;
+  int sum_a = 0, sum_b = 0;
+
+  pico_crypto_keypair(&pair);
+  pico_crypto_random(psig, sizeof(psig));
+  a_size = pf_create_block(a, (const uint8_t*)body, strlen(body), canonical, 2, pair);
+  b_size = pf_create_block(b, (const uint8_t*)body, strlen(body), reordered, 2, pair);
+  assert(a_size > 0 && a_size == b_size);
+
+  OK(a_size == pf_decode_block(a, &block, 0), "canonical layout verified");
+  OK(expect_body(&block, body), "canonical body");
+  OK(0 == memcmp(*block_psig(&block), psig, sizeof(psig)), "canonical psig");
+
+  OK(b_size == pf_decode_block(b, &block, 0), "reordered layout verified");
+  OK(expect_body(&block, body), "reordered body");
+  OK(0 == memcmp(*block_author(&block), pair.pk, sizeof(pair.pk)), "reordered author");
+
+  /* AUTHOR without PSIG, body must not be mistaken for a header */
+  a_size = pf_create_block(a, (const uint8_t*)body, strlen(body), canonical, 1, pair);
+  OK(a_size == pf_decode_block(a, &block, 0), "genesis layout verified");
+  OK(NULL == block_psig(&block), "genesis has no psig");
+
+  /* second AUTHOR falls back to the generic parser */
+  a_size = pf_create_block(a, (const uint8_t*)body, strlen(body), canonical, 2, pair);
+  a[64 + 1 + 34 + 1] = HDR_AUTHOR; /* sig, varint, author, psig id */
+  OK(EDUPHDR == pf_decode_block(a, &block, 1), "duplicate header detected");
+  OK(NULL == block.body && 0 == block.len && 0 == block.block_size, "failed decode clears previous block");
+  a_size = pf_create_block(a, (const uint8_t*)body, strlen(body), canonical, 2, pair);
+
+  MEASURE("canonical decode",
+    for (int i = 0; i < 1000000; ++i) sum_a += pf_decode_block(a, &block, 1));
+  MEASURE("generic decode",
+    for (int i = 0; i < 1000000; ++i) sum_b += pf_decode_block(b, &block, 1));
+  OK(sum_a == sum_b, "both layouts decode to same size");
+  return 0;
+}
+
+static int
+test_pop0201_block_view(void) {
+  pf_keypair_t pair = {0};
+  pico_feed_t feed = {0};
+  pf_iterator_t it_view = { .skip_verify = 1 };
+  pf_iterator_t it_block = { .skip_verify = 1 };
+  pf_block_view_t view;
+  int matched = 0;
+  char msg[16];
+
+  pico_crypto_keypair(&pair);
+  pf_init(&feed);
+  for (int i = 0; i < 100; i++) {
+    sprintf(msg, "block%i", i);
+    assert(pf_append(&feed, (uint8_t *)msg, strlen(msg), NULL, 0, pair) > 0);
+  }
+
+  while (0 == pf_next_view(&feed, &it_view, &view)) {
+    assert(0 == pf_next(&feed, &it_block));
+    if (view.id == it_block.block.bytes &&
+        0 == memcmp(view.id, it_block.block.id, sizeof(pf_signature_t)) &&
+        view.body == it_block.block.body &&
+        view.len == it_block.block.len &&
+        view.author == (const uint8_t *)block_author(&it_block.block) &&
+        view.psig == (const uint8_t *)block_psig(&it_block.block)) matched++;
+  }
+  OK(matched == 100, "views reference blocks in place");
+  OK(1 == pf_next(&feed, &it_block), "iterators in lockstep");
+
+  it_view = (pf_iterator_t){0};
+  assert(0 == pf_next_view(&feed, &it_view, &view));
+  OK(view.verified && view.psig == NULL, "genesis view verified without psig");
+
+  int views = 0, blocks = 0;
+  pf_block_t block = {0};
+  MEASURE("view scan",
+    for (int r = 0; r < 1000; ++r) {
+      it_view = (pf_iterator_t){ .skip_verify = 1 };
+      while (0 == pf_next_view(&feed, &it_view, &view)) views++;
+    });
+  MEASURE("block scan",
+    for (int r = 0; r < 1000; ++r) {
+      it_block = (pf_iterator_t){ .skip_verify = 1 };
+      while (0 == pf_next(&feed, &it_block)) { block = it_block.block; blocks++; }
+    });
+  OK(views == blocks && block.len > 0, "same amount of blocks visited");
+
+  pf_deinit(&feed);
+  return 0;
+}
+
+static int
+test_pop0201_decode_batch(void) {
+  pf_keypair_t pair = {0};
+  pico_feed_t feed = {0};
+  pf_columns_t *cols = calloc(1, sizeof(pf_columns_t));
+  pf_iterator_t iter = {0};
+  pf_block_view_t view;
+  const uint16_t hops = 7;
+  pf_header_t headers[] = { { APPHDR_HOPS, &hops } };
+  int total = 0, with_hops = 0, matching = 0, batches = 0, n;
+  int expected = 0;
+  char msg[16];
+
+  assert(cols != NULL);
+  pico_crypto_keypair(&pair);
+  pf_init(&feed);
+  for (int i = 0; i < 200; i++) {
+    sprintf(msg, "%s%i", i % 2 ? "odd" : "even", i);
+    assert(pf_append(&feed, (uint8_t *)msg, strlen(msg), headers, i % 3 == 0, pair) > 0);
+  }
+
+  cols->header = APPHDR_HOPS;
+  while ((n = pf_decode_batch(&feed, cols->next, 64, cols)) > 0) {
+    batches++;
+    for (int i = 0; i < n; ++i) {
+      assert(0 == pf_next_view(&feed, &iter, &view));
+      if (cols->body[i] == view.body && cols->len[i] == view.len &&
+          cols->author[i] == view.author && cols->psig[i] == view.psig &&
+          feed.buffer + cols->offset[i] == view.id) total++;
+      if (cols->value[i] != NULL && 0 == memcmp(cols->value[i], &hops, sizeof(hops))) with_hops++;
+      /* filter as a tight loop over two columns */
+      matching += cols->len[i] >= 3 && 0 == memcmp(cols->body[i], "odd", 3);
+    }
+  }
+  OK(0 == n, "scan ends cleanly");
+  OK(4 == batches, "200 blocks in batches of 64");
+  OK(200 == total, "columns match views");
+  OK(67 == with_hops, "selected header collected");
+  OK(100 == matching, "body prefix filter");
+  OK(cols->next == feed.tail, "cursor at tail");
+
+  cols->next = 0;
+  MEASURE("batch scan",
+    for (int r = 0; r < 100; ++r) {
+      cols->next = 0;
+      while ((n = pf_decode_batch(&feed, cols->next, PICOFEED_BATCH_SIZE, cols)) > 0) {
+        for (int i = 0; i < n; ++i) expected += cols->len[i] > 0;
+      }
+    });
+  OK(expected == 100 * 200, "all bodies visited");
+
+  free(cols);
+  pf_deinit(&feed);
+  return 0;
+}
+
+static int
+test_pop0201_scan(void) {
+  pf_keypair_t alice = {0}, bob = {0};
+  pico_feed_t feed = {0};
+  pf_block_view_t view;
+  const uint16_t hops = 2;
+  pf_header_t headers[] = { { APPHDR_HOPS, &hops } };
+  size_t hits[64], hits_mt[64];
+  pf_query_t query = {0};
+  char msg[32];
+  int n;
+
+  pico_crypto_keypair(&alice);
+  pico_crypto_keypair(&bob);
+  pf_init(&feed);
+  for (int i = 0; i < 120; i++) {
+    sprintf(msg, "%s says %s #%i", i % 4 ? "alice" : "bob", i % 10 ? "hi" : "bye", i);
+    assert(pf_append(&feed, (uint8_t *)msg, strlen(msg), headers, i % 5 == 0, i % 4 ? alice : bob) > 0);
+  }
+
+  query.author = bob.pk;
+  OK(30 == pf_scan(&feed, &query, 1, hits, 64), "author predicate");
+  assert(0 < pf_decode_view(feed.buffer + hits[1], &view, 0));
+  OK(view.len == 14 && 0 == memcmp(view.body, "bob says hi #4", 14), "hits in feed order");
+
+  query.pattern = (const uint8_t *)"bye";
+  query.pattern_len = 3;
+  OK(6 == pf_scan(&feed, &query, 1, hits, 64), "author and body pattern");
+
+  query = (pf_query_t){ .header = APPHDR_HOPS, .header_value = &hops };
+  query.body_prefix = (const uint8_t *)"alice";
+  query.body_prefix_len = 5;
+  n = pf_scan(&feed, &query, 1, hits, 64);
+  OK(18 == n, "header value and body prefix");
+  OK(n == pf_scan(&feed, &query, 4, hits_mt, 64), "threaded scan finds same hits");
+  OK(0 == memcmp(hits, hits_mt, (size_t)n * sizeof(size_t)), "threaded hits in order");
+  OK(n == pf_scan(&feed, &query, 200, NULL, 0), "more threads than blocks");
+
+  /* unmatched blocks are never verified */
+  query = (pf_query_t){ .author = bob.pk };
+  assert(0 < pf_decode_view(feed.buffer + hits[0], &view, 1));
+  ((uint8_t *)view.body)[0] ^= 0x20;
+  OK(30 == pf_scan(&feed, &query, 3, hits_mt, 64), "tampered non-match skipped");
+  query.author = alice.pk;
+  OK(EVERFAIL == pf_scan(&feed, &query, 3, hits_mt, 64), "tampered match rejected");
+  ((uint8_t *)view.body)[0] ^= 0x20;
+
+  /* broken linkage is detected without crypto */
+  assert(0 < pf_decode_view(feed.buffer + hits[5], &view, 1));
+  ((uint8_t *)view.psig)[0] ^= 1;
+  query.author = bob.pk;
+  OK(EPARENT == pf_scan(&feed, &query, 2, NULL, 0), "broken link rejected");
+  ((uint8_t *)view.psig)[0] ^= 1;
+
+  pf_deinit(&feed);
+  return 0;
+}
+
+static int
+test_pop0201_fork_index(void) {
+  pf_keypair_t alice = {0}, bob = {0};
+  pico_feed_t honest = {0}, fork = {0}, partial = {0}, other = {0};
+  pf_fork_index_t *index = pf_fork_index_create(0);
+  pf_equivocation_t found[4];
+  pf_block_t block = {0}, parent = {0};
+  char msg[16];
+
+  pico_crypto_keypair(&alice);
+  pico_crypto_keypair(&bob);
+  pf_init(&honest);
+  for (int i = 0; i < 120; i++) {
+    sprintf(msg, "block%i", i);
+    assert(pf_append(&honest, (uint8_t *)msg, strlen(msg), NULL, 0, i < 100 ? alice : bob) > 0);
+  }
+
+  pf_clone(&partial, &honest);
+  pf_truncate(&partial, 60);
+  pf_clone(&fork, &partial);
+  APPEND0(&fork, "evil twin", 9, alice);
+
+  OK(0 == pf_fork_index_feed(index, &honest, found, 4), "honest feed indexed");
+  OK(119 == pf_fork_index_size(index), "one entry per non-genesis block");
+  OK(0 == pf_fork_index_feed(index, &partial, found, 4), "known prefix is consistent");
+  OK(0 == pf_fork_index_feed(index, &honest, found, 4), "re-indexing is idempotent");
+
+  OK(1 == pf_fork_index_feed(index, &fork, found, 4), "equivocation detected");
+  assert(0 == pf_get(&honest, &block, 60));
+  assert(0 == pf_get(&honest, &parent, 59));
+  OK(0 == memcmp(found[0].author, alice.pk, sizeof(alice.pk)), "author reported");
+  OK(0 == memcmp(found[0].parent, parent.id, sizeof(parent.id)), "parent reported");
+  OK(0 == memcmp(found[0].first, block.id, sizeof(block.id)), "first child reported");
+  assert(0 == pf_get(&fork, &block, -1));
+  OK(0 == memcmp(found[0].second, block.id, sizeof(block.id)), "second child reported");
+
+  /* a second feed of the same author */
+  pf_init(&other);
+  APPEND0(&other, "another start", 13, alice);
+  OK(0 == pf_fork_index_feed(index, &other, NULL, 0), "second genesis is not an equivocation");
+  OK(119 == pf_fork_index_size(index), "genesis blocks not indexed");
+
+  /* child of the same parent from another author is not a conflict */
+  pf_deinit(&other);
+  pf_clone(&other, &partial);
+  APPEND0(&other, "evil twin", 9, bob);
+  OK(0 == pf_fork_index_feed(index, &other, NULL, 0), "authors tracked separately");
+
+  pf_fork_index_destroy(index);
+  pf_deinit(&other);
+  pf_deinit(&fork);
+  pf_deinit(&partial);
+  pf_deinit(&honest);
+  return 0;
+}
+
+static int
+test_pop0201_diff_many(void) {
+  pf_keypair_t pair = {0}, other = {0};
+  pico_feed_t local = {0};
+  pico_feed_t remotes[8] = {0};
+  const pico_feed_t *peers[64];
+  pf_diff_result_t res[64];
+  int diff = 0, agree = 0;
+  char msg[16];
+
+  pico_crypto_keypair(&pair);
+  pico_crypto_keypair(&other);
+  pf_init(&local);
+  for (int i = 0; i < 60; i++) {
+    sprintf(msg, "block%i", i);
+    assert(pf_append(&local, (uint8_t *)msg, strlen(msg), NULL, 0, pair) > 0);
+  }
+
+  pf_clone(&remotes[0], &local);                     /* equal */
+  pf_clone(&remotes[1], &local);                     /* behind */
+  pf_truncate(&remotes[1], 30);
+  pf_clone(&remotes[2], &local);                     /* ahead */
+  for (int i = 0; i < 5; ++i) APPEND0(&remotes[2], "more", 4, pair);
+  pf_slice(&remotes[3], &local, 10, 60);             /* tail slice */
+  pf_clone(&remotes[4], &local);                     /* diverged */
+  pf_truncate(&remotes[4], 20);
+  APPEND0(&remotes[4], "fork", 4, pair);
+  pf_init(&remotes[6]);
+  APPEND0(&remotes[6], "stranger", 8, other);
+  APPEND0(&remotes[6], "danger", 6, other);
+  pf_slice(&remotes[5], &remotes[6], 1, 2);          /* unrelated */
+  pf_truncate(&remotes[6], 0);                       /* empty */
+  pf_slice(&remotes[7], &remotes[2], 60, 65);        /* continues after tip */
+
+  for (int i = 0; i < 64; ++i) peers[i] = &remotes[i % 8];
+  OK(0 == pf_diff_many(&local, peers, 8, res), "diff many");
+  OK(OK == res[0].status && 0 == res[0].diff, "equal");
+  OK(OK == res[1].status && -30 == res[1].diff, "behind");
+  OK(OK == res[2].status && 5 == res[2].diff, "ahead");
+  OK(OK == res[3].status && 0 == res[3].diff, "tail slice in sync");
+  OK(DIVERGED == res[4].status, "diverged");
+  OK(UNRELATED == res[5].status, "unrelated");
+  OK(OK == res[6].status && -60 == res[6].diff, "empty remote");
+  OK(OK == res[7].status && 5 == res[7].diff, "remote starting after tip");
+
+  for (int i = 0; i < 8; ++i) {
+    int status = pf_diff(&local, peers[i], &diff);
+    agree += status == res[i].status && (status != OK || diff == res[i].diff);
+  }
+  OK(8 == agree, "same results as pf_diff()");
+
+  MEASURE("pf_diff x64",
+    for (int i = 0; i < 64; ++i) pf_diff(&local, peers[i], &diff));
+  MEASURE("pf_diff_many x64",
+    pf_diff_many(&local, peers, 64, res));
+
+  for (int i = 0; i < 8; ++i) pf_deinit(&remotes[i]);
+  pf_deinit(&local);
+  return 0;
+}
+
+static int
+test_pop0201_skip_proof(void) {
+  pf_keypair_t pair = {0};
+  pico_feed_t feed = {0}, proof = {0}, tail = {0};
+  pf_block_t block = {0}, tip = {0};
+  int longest = 0, valid = 0;
+  char msg[16];
+
+  pico_crypto_keypair(&pair);
+  pf_init(&feed);
+  feed.flags |= PF_FLAG_SKIP_LINKS;
+  for (int i = 0; i < 130; i++) {
+    sprintf(msg, "block%i", i);
+    assert(pf_append(&feed, (uint8_t *)msg, strlen(msg), NULL, 0, pair) > 0);
+  }
+  assert(0 == pf_last(&feed, &tip));
+
+  assert(0 == pf_get(&feed, &block, 1));
+  OK(NULL == pf_block_header(&block, HDR_SKIP), "no skip link next to genesis");
+  assert(0 == pf_get(&feed, &block, 96));
+  assert(0 == pf_get(&feed, &tip, 64));
+  OK(0 == memcmp(pf_block_header(&block, HDR_SKIP), tip.id, sizeof(tip.id)), "96 links to 64");
+  OK(pf_skip_index(96) == 64 && pf_skip_index(97) == 1, "skip indices");
+  assert(0 == pf_last(&feed, &tip));
+
+  for (int k = 0; k < 130; ++k) {
+    pf_init(&proof);
+    int n = pf_prove(&feed, k, &proof);
+    if (n > longest) longest = n;
+    valid += n > 0 && n == pf_len(&proof) && 0 == pf_verify_proof(&proof, tip.id, 129, k);
+    pf_deinit(&proof);
+  }
+  OK(130 == valid, "every ancestor provable");
+  OK(longest <= 3 * 8, "proofs are logarithmic");
+  log_debug("longest proof %i blocks", longest);
+
+  pf_init(&proof);
+  assert(pf_prove(&feed, 3, &proof) > 0);
+  OK(0 == pf_verify_proof(&proof, tip.id, 129, 3), "proof verifies");
+  OK(EBOUNDS == pf_verify_proof(&proof, tip.id, 129, 4), "wrong target rejected");
+  OK(EVERFAIL == pf_verify_proof(&proof, block.id, 129, 3), "wrong tip rejected");
+  assert(0 == pf_get(&proof, &block, 1));
+  ((uint8_t *)block.body)[0] ^= 1;
+  OK(EVERFAIL == pf_verify_proof(&proof, tip.id, 129, 3), "tampered block rejected");
+  pf_deinit(&proof);
+
+  /* links can only be resolved from genesis */
+  pf_init(&tail);
+  pf_slice(&tail, &feed, 100, 130);
+  tail.flags |= PF_FLAG_SKIP_LINKS;
+  OK(EBOUNDS == APPEND0(&tail, "more", 4, pair), "partial feed cannot link");
+  pf_init(&proof);
+  OK(EBOUNDS == pf_prove(&tail, 10, &proof), "partial feed cannot prove");
+  pf_deinit(&proof);
+
+  /* shifting drops genesis and with it older skip targets */
+  pf_deinit(&tail);
+  pf_clone(&tail, &feed);
+  OK(3 == pf_shift(&tail, 3), "skip linked feed shifted");
+  OK(EBOUNDS == APPEND0(&tail, "more", 4, pair), "shifted feed cannot link");
+  pf_init(&proof);
+  OK(EBOUNDS == pf_prove(&tail, 10, &proof), "shifted feed cannot prove");
+  pf_deinit(&proof);
+
+  pf_deinit(&tail);
+  pf_clone(&tail, &feed);
+  pf_set_max_size(&tail, tail.tail - tail.head);
+  OK(0 < APPEND0(&tail, "more", 4, pair), "capped append drops genesis");
+  OK(EBOUNDS == APPEND0(&tail, "more", 4, pair), "capped feed cannot link after genesis dropped");
+
+  /* without skip links only adjacent ancestors are provable */
+  pf_deinit(&tail);
+  pf_init(&tail);
+  for (int i = 0; i < 100; i++) {
+    sprintf(msg, "plain%i", i);
+    APPEND0(&tail, msg, strlen(msg), pair);
+  }
+  pf_init(&proof);
+  OK(EUNKHDR == pf_prove(&tail, 10, &proof), "plain feed cannot prove");
+  pf_deinit(&proof);
+  pf_init(&proof);
+  OK(2 == pf_prove(&tail, 98, &proof), "parent provable without skip links");
+  pf_deinit(&proof);
+
+  pf_deinit(&tail);
+  pf_deinit(&feed);
+  return 0;
+}
+
+/* writes an unsigned block linking to `psig`, enough for offset scans */
+static size_t
+write_unsigned_block(uint8_t *dst, uint32_t seed, const uint8_t *psig, size_t body_len) {
+  size_t o = sizeof(pf_signature_t);
+  size_t data_size = 2 + sizeof(pf_key_t) + (psig ? 2 + sizeof(pf_signature_t) : 0) + body_len;
+
+  for (size_t i = 0; i < sizeof(pf_signature_t); ++i) dst[i] = (uint8_t)((seed * 2654435761u) >> (i % 4 * 8)) ^ (uint8_t)i;
+  while (data_size >= 0x80) {
+    dst[o++] = (data_size & 0x7F) | 0x80;
+    data_size >>= 7;
+  }
+  dst[o++] = (uint8_t)data_size;
+  dst[o++] = 0;
+  dst[o++] = HDR_AUTHOR;
+  memset(dst + o, 0xA5, sizeof(pf_key_t));
+  o += sizeof(pf_key_t);
+  if (psig) {
+    dst[o++] = 0;
+    dst[o++] = HDR_PSIG;
+    memcpy(dst + o, psig, sizeof(pf_signature_t));
+    o += sizeof(pf_signature_t);
+  }
+  for (size_t i = 0; i < body_len; ++i) dst[o++] = (uint8_t)('a' + (seed + i) % 26);
+  return o;
+}
+
+static int
+test_pop0201_offset_index(void) {
+  pf_keypair_t pair = {0};
+  pico_feed_t feed = {0}, big = {0};
+  pf_index_t index = {0};
+  pf_iterator_t iter = { .skip_verify = 1 };
+  pf_block_view_t view;
+  uint8_t *body = malloc(10000);
+  int same = 0, len;
+
+  assert(body != NULL);
+  pico_crypto_keypair(&pair);
+  pf_init(&feed);
+  for (int i = 0; i < 120; i++) {
+    size_t body_len = 16;
+    sprintf((char *)body, "block%04i", i);
+    if (i > 1 && i % 7 == 0) {
+      /* bodies carrying copies of earlier blocks look like boundaries */
+      body_len = (size_t)pf_next_block_offset(feed.buffer + PICOFEED_MAGIC_SIZE) * 2 + 9;
+      memcpy(body + 9, feed.buffer + PICOFEED_MAGIC_SIZE, body_len - 9);
+    }
+    if (i == 60) body_len = 10000;
+    assert(pf_append(&feed, body, body_len, NULL, 0, pair) > 0);
+  }
+
+  len = pf_index_build(&feed, 8, &index);
+  OK(120 == len && len == index.len, "all boundaries found");
+  while (0 == pf_next_view(&feed, &iter, &view)) {
+    same += feed.buffer + index.offsets[iter.idx] == view.id;
+  }
+  OK(120 == same, "offsets equal sequential walk");
+  pf_index_free(&index);
+
+  OK(120 == pf_index_build(&feed, 1, &index), "single threaded build");
+  pf_index_free(&index);
+
+  feed.tail -= 5;
+  OK(EFAILED == pf_index_build(&feed, 8, &index), "truncated block detected");
+  feed.tail += 5;
+
+  /* synthetic 30MB feed */
+  const int nblocks = 150000;
+  big.capacity = (size_t)nblocks * 320;
+  big.buffer = malloc(big.capacity);
+  assert(big.buffer != NULL);
+  memcpy(big.buffer, feed.buffer, PICOFEED_MAGIC_SIZE);
+  big.tail = PICOFEED_MAGIC_SIZE;
+  for (int i = 0, prev = 0; i < nblocks; ++i) {
+    const size_t offset = big.tail;
+    big.tail += write_unsigned_block(big.buffer + offset, (uint32_t)i, i ? big.buffer + prev : NULL, 40 + (size_t)(i * 37 % 160));
+    prev = (int)offset;
+  }
+
+  MEASURE("pf_len", len = pf_len(&big));
+  OK(nblocks == len, "synthetic feed length");
+  MEASURE("sequential index", len = pf_index_build(&big, 1, &index));
+  pf_index_free(&index);
+  MEASURE("parallel index", len = pf_index_build(&big, 8, &index));
+  OK(nblocks == len, "parallel index length");
+  OK(big.tail - (size_t)pf_next_block_offset(big.buffer + index.offsets[len - 1]) == index.offsets[len - 1], "last block ends at tail");
+
+  pf_index_free(&index);
+  free(big.buffer);
+  free(body);
+  pf_deinit(&feed);
+  return 0;
+}
+
+static void
+write_file(const char *path, const uint8_t *bytes, size_t size) {
+  FILE *file = fopen(path, "wb");
+  assert(file != NULL);
+  assert(size == fwrite(bytes, 1, size, file));
+  fclose(file);
+}
+
+static int
+test_pop0201_sidecar(void) {
+  const char *feed_path = "/tmp/picofeed_test.pic";
+  const char *index_path = "/tmp/picofeed_test.pix";
+  pf_keypair_t pair = {0};
+  pico_feed_t feed = {0}, big = {0};
+  pf_sidecar_t *sc;
+  pf_block_t block = {0};
+  uint8_t dst[1024];
+  size_t size = 0;
+  int fd, same = 0;
+  char msg[16];
+
+  pico_crypto_keypair(&pair);
+  pf_init(&feed);
+  for (int i = 0; i < 10; i++) {
+    sprintf(msg, "block%i", i);
+    APPEND0(&feed, msg, strlen(msg), pair);
+  }
+  remove(index_path);
+  write_file(feed_path, feed.buffer, feed.tail);
+  OK(10 == pf_sidecar_sync(&feed, index_path), "sidecar written");
+
+  fd = open(feed_path, O_RDONLY);
+  sc = pf_sidecar_open(index_path, fd);
+  OK(sc != NULL && 10 == pf_sidecar_len(sc), "sidecar opened");
+  ssize_t n = pf_file_get(fd, sc, 7, dst, sizeof(dst));
+  OK(n > 0 && n == pf_decode_block(dst, &block, 0), "single block read and verified");
+  OK(expect_body(&block, "block7"), "block body");
+  OK(EBOUNDS == pf_file_get(fd, sc, 10, dst, sizeof(dst)), "out of bounds");
+  OK(EBOUNDS == pf_file_get(fd, sc, -1, dst, 16), "small destination");
+  pf_sidecar_close(sc);
+  close(fd);
+
+  /* multi page feed, extended incrementally */
+  big.capacity = 1200 * 320;
+  big.buffer = malloc(big.capacity);
+  assert(big.buffer != NULL);
+  memcpy(big.buffer, feed.buffer, PICOFEED_MAGIC_SIZE);
+  big.tail = PICOFEED_MAGIC_SIZE;
+  size_t offsets[1200];
+  for (int i = 0; i < 1200; ++i) {
+    offsets[i] = big.tail;
+    big.tail += write_unsigned_block(big.buffer + big.tail, (uint32_t)i, i ? big.buffer + offsets[i - 1] : NULL, 40 + (size_t)(i * 37 % 160));
+  }
+
+  const size_t full = big.tail;
+  big.tail = offsets[700];
+  remove(index_path);
+  OK(700 == pf_sidecar_sync(&big, index_path), "partial feed indexed");
+  big.tail = full;
+  OK(1200 == pf_sidecar_sync(&big, index_path), "sidecar extended");
+  OK(1200 == pf_sidecar_sync(&big, index_path), "sync without new blocks");
+  write_file(feed_path, big.buffer, big.tail);
+
+  fd = open(feed_path, O_RDONLY);
+  sc = pf_sidecar_open(index_path, fd);
+  assert(sc != NULL);
+  for (int i = 0; i < 1200; ++i) {
+    ssize_t offset = pf_sidecar_offset(sc, i, &size);
+    same += offset == (ssize_t)offsets[i] &&
+      size == (size_t)pf_next_block_offset(big.buffer + offsets[i]);
+  }
+  OK(1200 == same, "offsets match across pages");
+  n = pf_file_get(fd, sc, 1100, dst, sizeof(dst));
+  OK(n > 0 && 0 == memcmp(dst, big.buffer + offsets[1100], (size_t)n), "block bytes read");
+  pf_sidecar_close(sc);
+  close(fd);
+
+  /* rewritten feed file invalidates the sidecar */
+  write_file(feed_path, feed.buffer, feed.tail);
+  fd = open(feed_path, O_RDONLY);
+  OK(NULL == pf_sidecar_open(index_path, fd), "stale sidecar rejected");
+  close(fd);
+  OK(10 == pf_sidecar_sync(&feed, index_path), "stale sidecar rebuilt");
+
+  remove(index_path);
+  remove(feed_path);
+  free(big.buffer);
+  pf_deinit(&feed);
+  return 0;
+}
+
+static int
+test_pop0201_send(void) {
+  const char *path = "/tmp/picofeed_test_send.pic";
+  pf_keypair_t pair = {0};
+  pico_feed_t feed = {0}, mapped = {0}, slice = {0}, copy = {0};
+  uint8_t received[4096];
+  int sv[2];
+  int fd;
+  char msg[16];
+
+  pico_crypto_keypair(&pair);
+  pf_init(&feed);
+  for (int i = 0; i < 12; i++) {
+    sprintf(msg, "block%i", i);
+    APPEND0(&feed, msg, strlen(msg), pair);
+  }
+  /* trailing half-written block is ignored */
+  write_file(path, feed.buffer, feed.tail);
+  fd = open(path, O_RDWR | O_APPEND);
+  assert(fd >= 0);
+  assert(40 == write(fd, feed.buffer + PICOFEED_MAGIC_SIZE, 40));
+
+  OK(12 == pf_map(&mapped, fd), "feed file mapped");
+  OK(mapped.tail == feed.tail, "partial block excluded");
+  OK(EFAILED == APPEND0(&mapped, "nope", 4, pair), "mapped feed is read-only");
+  OK(12 == pf_verify_from(&mapped, 0, NULL, NULL), "mapped blocks verify");
+  OK(EFAILED == pf_truncate(&mapped, 4) && 12 == pf_len(&mapped), "mapped feed cannot be truncated");
+  OK(EFAILED == pf_slice(&mapped, &feed, 0, 2), "mapped feed cannot be a slice target");
+
+  /* shortest blocks at the end of the file are complete */
+  {
+    uint8_t tiny[PICOFEED_MAGIC_SIZE + 2 * 67 + sizeof(pf_signature_t) + 1] = {0};
+    char tiny_path[] = "/tmp/picofeed_test_XXXXXX";
+    pico_feed_t small = {0};
+    memcpy(tiny, PiC0, PICOFEED_MAGIC_SIZE);
+    tiny[PICOFEED_MAGIC_SIZE + 64] = 2;
+    tiny[PICOFEED_MAGIC_SIZE + 67 + 64] = 2;
+    tiny[PICOFEED_MAGIC_SIZE + 2 * 67 + 64] = 0x81; /* size varint still being written */
+    int tiny_fd = mkstemp(tiny_path);
+    assert(tiny_fd >= 0 && (ssize_t)sizeof(tiny) == write(tiny_fd, tiny, sizeof(tiny)));
+    OK(2 == pf_map(&small, tiny_fd), "trailing 67 byte block mapped");
+    OK(small.tail == PICOFEED_MAGIC_SIZE + 2 * 67, "cut size varint excluded");
+    pf_deinit(&small);
+    close(tiny_fd);
+    remove(tiny_path);
+  }
+
+  assert(0 == socketpair(AF_UNIX, SOCK_STREAM, 0, sv));
+  ssize_t n = pf_send(&mapped, fd, sv[0], 3, 8);
+  pf_slice(&slice, &feed, 3, 8);
+  OK(n == (ssize_t)slice.tail, "slice size sent");
+  OK(n == read(sv[1], received, sizeof(received)), "slice received");
+  OK(0 == memcmp(received, slice.buffer, slice.tail), "received bytes equal pf_slice()");
+
+  OK(PICOFEED_MAGIC_SIZE == pf_send(&mapped, fd, sv[0], 5, 5), "empty slice is a bare magic");
+  assert(PICOFEED_MAGIC_SIZE == read(sv[1], received, sizeof(received)));
+
+  pf_clone(&copy, &mapped);
+  OK(13 == APPEND0(&copy, "writable", 8, pair), "clone of mapped feed is writable");
+
+  close(sv[0]);
+  close(sv[1]);
+  close(fd);
+  pf_deinit(&copy);
+  pf_deinit(&slice);
+  pf_deinit(&mapped);
+  pf_deinit(&feed);
+  remove(path);
+  return 0;
+}
+
+static int
+test_pop0201_append_many(void) {
+  enum { N = 200 };
+  pf_keypair_t pair = {0};
+  pico_feed_t looped = {0}, batched = {0};
+  char msgs[N][16];
+  const uint8_t *bodies[N];
+  size_t lens[N];
+
+  pico_crypto_keypair(&pair);
+  for (int i = 0; i < N; i++) {
+    sprintf(msgs[i], "entry%i", i);
+    bodies[i] = (const uint8_t *)msgs[i];
+    lens[i] = strlen(msgs[i]);
+  }
+
+  pf_init(&looped);
+  pf_init(&batched);
+  MEASURE("append loop",
+    for (int i = 0; i < N; i++) pf_append(&looped, bodies[i], lens[i], NULL, 0, pair)
+  );
+  MEASURE("append many",
+    OK(1 == pf_append_many(&batched, bodies, lens, 1, pair), "genesis appended");
+    OK(N == pf_append_many(&batched, bodies + 1, lens + 1, N - 1, pair), "batch appended")
+  );
+  OK(looped.tail == batched.tail, "same feed size");
+  OK(0 == memcmp(looped.buffer, batched.buffer, looped.tail), "same bytes as pf_append()");
+  OK(N == pf_verify_from(&batched, 0, NULL, NULL), "batched blocks verify");
+
+  const uint8_t *invalid[2] = { bodies[0], (const uint8_t *)"\0zero" };
+  size_t invalid_lens[2] = { lens[0], 5 };
+  OK(EFAILED == pf_append_many(&batched, invalid, invalid_lens, 2, pair), "invalid body rejected");
+  OK(N == pf_len(&batched), "nothing appended on error");
+  OK(N == pf_append_many(&batched, bodies, lens, 0, pair), "empty batch");
+
+  pf_deinit(&looped);
+  pf_deinit(&batched);
+  return 0;
+}
+
+static int
+test_pop0201_signer(void) {
+  enum { FEEDS = 32, BLOCKS = 16 };
+  pf_keypair_t pairs[FEEDS];
+  pico_feed_t feeds[FEEDS], serial[FEEDS];
+  pf_sign_completion_t done[FEEDS];
+  int last[FEEDS];
+  char msg[24];
+  int collected = 0;
+  int ordered = 1;
+
+  for (int f = 0; f < FEEDS; f++) {
+    memset(&pairs[f], 0, sizeof(pairs[f]));
+    pico_crypto_keypair(&pairs[f]);
+    pf_init(&feeds[f]);
+    pf_init(&serial[f]);
+    last[f] = 0;
+  }
+
+  MEASURE("serial appends",
+    for (int b = 0; b < BLOCKS; b++) for (int f = 0; f < FEEDS; f++) {
+      sprintf(msg, "feed%i block%i", f, b);
+      APPEND0(&serial[f], msg, strlen(msg), pairs[f]);
+    }
+  );
+
+  pf_signer_t *signer = pf_signer_create(4);
+  OK(signer != NULL, "signer started");
+  OK(EFAILED == pf_signer_submit(signer, &feeds[0], (const uint8_t *)"\0", 1, pairs[0], NULL), "invalid body rejected");
+
+  MEASURE("signer appends",
+    for (int b = 0; b < BLOCKS; b++) for (int f = 0; f < FEEDS; f++) {
+      sprintf(msg, "feed%i block%i", f, b);
+      pf_signer_submit(signer, &feeds[f], (const uint8_t *)msg, strlen(msg), pairs[f], (void *)(intptr_t)f);
+    }
+    while (collected < FEEDS * BLOCKS) {
+      int n = pf_signer_poll(signer, done, FEEDS, 1);
+      for (int i = 0; i < n; i++) {
+        const int f = (int)(intptr_t)done[i].ctx;
+        if (done[i].feed != &feeds[f] || done[i].result != last[f] + 1) ordered = 0;
+        last[f] = done[i].result;
+      }
+      collected += n;
+    }
+  );
+  OK(ordered, "completions arrive in per-feed order");
+  OK(0 == pf_signer_poll(signer, done, FEEDS, 1), "nothing pending");
+
+  int same = 1;
+  for (int f = 0; f < FEEDS; f++) {
+    same = same && feeds[f].tail == serial[f].tail &&
+      0 == memcmp(feeds[f].buffer, serial[f].buffer, serial[f].tail) &&
+      BLOCKS == pf_verify_from(&feeds[f], 0, NULL, NULL);
+  }
+  OK(same, "feeds equal serially appended feeds");
+
+  pf_signer_destroy(signer);
+  for (int f = 0; f < FEEDS; f++) {
+    pf_deinit(&feeds[f]);
+    pf_deinit(&serial[f]);
+  }
+  return 0;
+}
+
+/* reference backend on top of the streaming signer of the default backend,
+ * leaves sign_iov/verify_iov unset to cover the gathering fallback */
+static const pf_crypto_backend_t *reference;
+static int streaming_derived = 0;
+
+static void
+streaming_sign(pf_signature_t signature, const uint8_t *message, size_t len, const pf_keypair_t *pair) {
+  struct iovec iov = { .iov_base = (void *)message, .iov_len = len };
+  reference->sign_iov(signature, &iov, 1, pair);
+}
+
+static int
+streaming_verify(const pf_signature_t signature, const uint8_t *message, size_t len, const pf_key_t pk) {
+  struct iovec iov = { .iov_base = (void *)message, .iov_len = len };
+  return reference->verify_iov(signature, &iov, 1, pk);
+}
+
+static int
+streaming_verify_batch(const pf_verify_item_t *items, int n, int *results) {
+  int err = 0;
+  for (int i = 0; i < n; i++) {
+    int r = streaming_verify(items[i].signature, items[i].message, items[i].message_len, items[i].pk);
+    if (results != NULL) results[i] = r;
+    if (r) err = -1;
+  }
+  return err;
+}
+
+static void
+streaming_public_key(pf_key_t pk, const uint8_t seed[32]) {
+  streaming_derived++;
+  reference->public_key(pk, seed);
+}
+
+static void
+streaming_keypair(pf_keypair_t *pair) {
+  pico_crypto_random(pair->seed, sizeof(pair->seed));
+  streaming_public_key(pair->pk, pair->seed);
+}
+
+static int
+unavailable(void) {
+  return 0;
+}
+
+static const pf_crypto_backend_t streaming_backend = {
+  .name = "streaming",
+  .keypair = streaming_keypair,
+  .sign = streaming_sign,
+  .verify = streaming_verify,
+  .verify_batch = streaming_verify_batch,
+  .public_key = streaming_public_key
+};
+
+static const pf_crypto_backend_t missing_backend = {
+  .name = "missing",
+  .available = unavailable,
+  .keypair = streaming_keypair,
+  .sign = streaming_sign,
+  .verify = streaming_verify,
+  .verify_batch = streaming_verify_batch,
+  .public_key = streaming_public_key
+};
+
+static int
+conformance(const char *name) {
+  pf_keypair_t pair = {0}, fresh = {0};
+  pf_signature_t sig;
+  uint8_t block1[101], block2[167], tampered[167];
+  pico_feed_t feed = {0};
+  int results[3];
+
+  OK(pico_crypto_select(name) == pico_crypto_backend(), "backend selected");
+  log_info("  backend %s", pico_crypto_backend()->name);
+  load_reference_pair(&pair);
+  hex_to_bytes(JS_BLOCK1_HEX, block1, sizeof(block1));
+  hex_to_bytes(JS_BLOCK2_HEX, block2, sizeof(block2));
+  memcpy(tampered, block2, sizeof(block2));
+  tampered[sizeof(tampered) - 1] ^= 1;
+
+  pico_crypto_sign(sig, block1 + 64, sizeof(block1) - 64, pair);
+  OK(0 == memcmp(sig, block1, sizeof(sig)), "signature equals JS vector");
+  OK(0 == pico_crypto_verify(block2, block2 + 64, sizeof(block2) - 64, pair.pk), "JS vector verifies");
+
+  const pf_verify_item_t items[3] = {
+    { block1, block1 + 64, sizeof(block1) - 64, pair.pk },
+    { block2, block2 + 64, sizeof(block2) - 64, pair.pk },
+    { tampered, tampered + 64, sizeof(tampered) - 64, pair.pk }
+  };
+  OK(0 == pico_crypto_verify_batch(items, 2, NULL), "batch of valid vectors");
+  OK(0 != pico_crypto_verify_batch(items, 3, results), "tampered batch fails");
+  OK(0 == results[0] && 0 == results[1] && 0 != results[2], "only tampered item rejected");
+
+  pico_crypto_keypair(&fresh);
+  pico_crypto_sign(sig, block1, sizeof(block1), fresh);
+  OK(0 == pico_crypto_verify(sig, block1, sizeof(block1), fresh.pk), "generated pair signs");
+
+  const struct iovec iov[2] = {
+    { .iov_base = block1 + 64, .iov_len = 10 },
+    { .iov_base = block1 + 74, .iov_len = sizeof(block1) - 74 }
+  };
+  pico_crypto_sign_iov(sig, iov, 2, pair);
+  OK(0 == memcmp(sig, block1, sizeof(sig)), "iov signature equals JS vector");
+  OK(0 != pico_crypto_verify_iov(block2, iov, 2, pair.pk), "iov verify rejects wrong signature");
+  OK(0 == pico_crypto_verify_iov(sig, iov, 2, pair.pk), "iov signature verifies");
+
+  pf_init(&feed);
+  APPEND0(&feed, "B0", 2, pair);
+  APPEND0(&feed, "B1", 2, pair);
+  assert_buffer_equals_hex(feed.buffer, feed.tail, JS_FEED_B0_B1_HEX);
+  OK(2 == pf_verify_from(&feed, 0, NULL, NULL), "feed bytes equal JS vector");
+  pf_deinit(&feed);
+  return 0;
+}
+
+static int
+test_crypto_backends(void) {
+  const pf_crypto_backend_t *previous = pico_crypto_backend();
+  const uint8_t block_seed[32] = { 0x5e, 0xed };
+  pf_key_t pk;
+  reference = previous;
+  OK(0 == strcmp("monocypher", previous->name), "portable backend is default");
+  OK(0 == pico_crypto_register(&streaming_backend), "backend registered");
+  OK(0 == pico_crypto_register(&missing_backend), "unsupported backend registered");
+  OK(NULL == pico_crypto_select("missing"), "unsupported backend not selectable");
+  OK(NULL == pico_crypto_select("nope"), "unknown backend not selectable");
+  OK(&streaming_backend == pico_crypto_select(NULL), "best available backend selected");
+
+  if (conformance("streaming")) return -1;
+  const int derived = streaming_derived;
+  pico_public_from_secret(pk, block_seed);
+  OK(derived + 1 == streaming_derived, "key derivation uses the active backend");
+  if (conformance("monocypher")) return -1;
+
+  pico_crypto_select("streaming");
+  OK(previous == pico_crypto_select(previous->name), "previous backend restored");
+  return 0;
+}
+
+#ifdef __linux__
+/* shm objects whose name starts with prefix */
+static int
+count_shm(const char *prefix) {
+  DIR *dir = opendir("/dev/shm");
+  struct dirent *entry;
+  int n = 0;
+  assert(dir != NULL);
+  while ((entry = readdir(dir)) != NULL) n += 0 == strncmp(entry->d_name, prefix, strlen(prefix));
+  closedir(dir);
+  return n;
+}
+#endif
+
+static int
+test_pop0201_shared_cache(void) {
+  const char *name = "/picofeed_test_cache";
+  pf_keypair_t pair = {0};
+  pico_feed_t feed = {0}, shared = {0}, fresh = {0};
+  uint64_t generation = 0;
+  int diff = 0;
+  char msg[16];
+
+  pico_crypto_keypair(&pair);
+  pf_init(&feed);
+  for (int i = 0; i < 10; i++) {
+    sprintf(msg, "cached%i", i);
+    APPEND0(&feed, msg, strlen(msg), pair);
+  }
+
+  pf_cache_unlink(name);
+  OK(NULL == pf_cache_open(name, 0), "missing cache not opened");
+  /* a creator that has not sized the object yet */
+  int fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+  OK(fd >= 0 && NULL == pf_cache_open(name, 0), "unsized cache not mapped");
+  close(fd);
+  shm_unlink(name);
+  pf_cache_t *cache = pf_cache_open(name, 1);
+  OK(cache != NULL, "cache created");
+  OK(0 == pf_cache_generation(cache, pair.pk), "key not cached");
+  OK(EFAILED == pf_cache_attach(cache, pair.pk, &shared, NULL), "nothing to attach");
+  OK(2 == pf_cache_publish(cache, pair.pk, &feed), "snapshot published");
+
+  pid_t pid = fork();
+  assert(pid >= 0);
+  if (pid == 0) {
+    pf_cache_t *child = pf_cache_open(name, 0);
+    int ok = child != NULL &&
+      10 == pf_cache_attach(child, pair.pk, &shared, &generation) &&
+      2 == generation &&
+      10 == pf_verify_from(&shared, 0, NULL, NULL);
+    _exit(ok ? 0 : 1);
+  }
+  int status = -1;
+  waitpid(pid, &status, 0);
+  OK(WIFEXITED(status) && 0 == WEXITSTATUS(status), "other process attaches snapshot");
+
+  OK(10 == pf_cache_attach(cache, pair.pk, &shared, &generation), "snapshot attached");
+  OK(shared.flags & PF_FLAG_MAPPED, "snapshot is mapped");
+  OK(0 == pf_diff(&feed, &shared, &diff) && 0 == diff, "snapshot equals feed");
+  OK(EFAILED == APPEND0(&shared, "nope", 4, pair), "snapshot is read-only");
+
+  APPEND0(&feed, "fresh", 5, pair);
+  OK(4 == pf_cache_publish(cache, pair.pk, &feed), "append republished");
+  OK(generation != pf_cache_generation(cache, pair.pk), "generation invalidates readers");
+  OK(10 == pf_len(&shared), "old snapshot stays valid");
+  OK(11 == pf_cache_attach(cache, pair.pk, &fresh, &generation) && 4 == generation, "new snapshot attached");
+
+#ifdef __linux__
+  /* kill a publisher that spends most of its time holding the lock */
+  pid = fork();
+  assert(pid >= 0);
+  if (pid == 0) {
+    pf_cache_t *child = pf_cache_open(name, 0);
+    for (;;) pf_cache_publish(child, pair.pk, &feed);
+  }
+  usleep(20000);
+  kill(pid, SIGKILL);
+  waitpid(pid, &status, 0);
+  const int64_t g = pf_cache_publish(cache, pair.pk, &feed);
+  OK(g > 4 && 0 == (g & 1), "cache usable after publisher crash");
+  OK(1 == count_shm("picofeed_test_cache."), "crashed publisher leaks no snapshot");
+#endif
+
+  pf_deinit(&fresh);
+  pf_deinit(&shared);
+  pf_cache_close(cache);
+  OK(0 == pf_cache_unlink(name), "cache removed");
+  pf_deinit(&feed);
+  return 0;
+}
+
 #define run_test(FUNC) do { \
   log_info("# " #FUNC); \
   if ((FUNC()) != 0) { \
@@ -545,9 +2125,32 @@ main(void) {
   run_test(test_pop0201_feed_diff);
   run_test(test_pop0201_feed_slice);
   run_test(test_pop02_fast_iterator);
+  run_test(test_pop0201_verify_from);
+  run_test(test_pop0201_watermark);
+  run_test(test_pop0201_digest);
+  run_test(test_pop0201_shift);
+  run_test(test_pop0201_capped_feed);
+  run_test(test_pop0201_inline_feed);
+  run_test(test_pop0201_verify_pool);
+  run_test(test_pop0201_ingest);
+  run_test(test_pop02_iov_block);
+  run_test(test_pop02_canonical_decode);
+  run_test(test_pop0201_block_view);
+  run_test(test_pop0201_decode_batch);
+  run_test(test_pop0201_scan);
+  run_test(test_pop0201_fork_index);
+  run_test(test_pop0201_diff_many);
+  run_test(test_pop0201_skip_proof);
+  run_test(test_pop0201_offset_index);
+  run_test(test_pop0201_sidecar);
+  run_test(test_pop0201_send);
+  run_test(test_pop0201_append_many);
+  run_test(test_pop0201_signer);
+  run_test(test_pop0201_shared_cache);
   run_test(test_js_v8_block_vectors);
   run_test(test_js_v8_feed_bytes);
   run_test(test_js_v8_slice_and_truncate);
+  run_test(test_crypto_backends);
   log_info("Test end");
 #ifdef BENCH
   dump_stats();
@@ -34,6 +34,36 @@ export function toU8 (o) {
   if (typeof o === 'string') return s2b(o) // experimental / might regret
   throw new Error('Uint8Array coercion failed')
 }
+
+// ------ Native engine
+/**
+ * Optional C addon built with `npm run native`, loaded on first use,
+ * set PICOFEED_NATIVE=0 to force the pure JS path.
+ * @returns {any} addon or null
+ */
+let addon
+function native () {
+  if (addon !== undefined) return addon
+  addon = null
+  if (typeof process === 'undefined' || process.env?.PICOFEED_NATIVE === '0') return addon
+  /* c8 ignore start */ // `npm run cov` runs the pure JS path, test.js checks the addon separately
+  try { // getBuiltinModule() keeps the load synchronous and hidden from bundlers
+    const { createRequire } = process.getBuiltinModule('node:module')
+    addon = createRequire(import.meta.url)('./c/build/Release/picofeed.node')
+  } catch (_) {}
+  return addon
+  /* c8 ignore stop */
+}
+
+/** Imports a node builtin, hidden from bundlers
+ * @returns {Promise<any>} module or null outside of node */
+async function nodeImport (specifier) {
+  if (!globalThis.process?.versions?.node) return null
+  try {
+    return await import(specifier)
+  } catch (_) { return null }
+}
+
 /** @type {(o: *) => o is Feed} */
 export function isFeed (o) { return !!(o && o[symFeed]) }
 /** @type {(o: *) => o is Block} */
@@ -67,7 +97,7 @@ export function generatePrivateKey () {
 
 /** @type {(secret: SecretKey) => PublicHex} */
 export function getPublicKey (secret) {
-  return toHex(ed25519.getPublicKey(secret))
+  return toHex(native() ? native().publicKey(toU8(secret)) : ed25519.getPublicKey(secret))
 }
 
 /* Deprecate ? */
@@ -75,9 +105,22 @@ export const PIC0 = s2b('PIC0')
 // <16 RESERVED KNOWN SIZE HEADERS
 export const HDR_AUTHOR = 1
 export const HDR_PSIG = 2
-// 32..64 FIXED SIZE HEADERS uint16 values
-// 64..96 FIXED SIZE HEADERS uint32 values
-// >128 APPLICATION DEFINED HEADERS
+export const HDR_SKIP = 0x7F // id of an older ancestor, written by the C engine
+// Other ids below 0x80 encode their value size (see pf_header_size() in c/picofeed.h):
+// 0x03..0x0F u8, 0x10..0x1F u16, 0x20..0x3F u32, 0x40..0x5F u64, 0x60..0x6F 32 bytes, 0x70..0x7F 64 bytes
+// >=0x80 APPLICATION DEFINED HEADERS
+
+/**
+ * Value size of a decoded header, unknown headers are skipped by their size class
+ * @param {number} type header id
+ * @returns {usize} bytes following the 2 byte header prefix
+ */
+function headerSize (type) {
+  if (type === HDR_AUTHOR) return 32
+  if (type === HDR_PSIG) return 64
+  if (type === 0 || type >= 0x80) throw new Error(`DecodedUnknownHeader: ${type}`)
+  return type < 0x10 ? 1 : type < 0x20 ? 2 : type < 0x40 ? 4 : type < 0x60 ? 8 : type < 0x70 ? 32 : 64
+}
 
 /**
  * Estimates size of a block given it's body.
@@ -134,7 +177,7 @@ export function createBlockSegment (buffer, offset = 0, data, sk, headers = [])
   }
   buffer.set(data, o)
   const message = buffer.subarray(64)
-  const sig = ed25519.sign(message, sk)
+  const sig = native() ? native().sign(message, toU8(sk)) : ed25519.sign(message, sk)
   buffer.set(sig, 0)
   return buffer
 }
@@ -145,6 +188,42 @@ export function createBlockSegment (buffer, offset = 0, data, sk, headers = [])
 /** @typedef {(block: Block, stop: (after: boolean) => void) => void} InteractiveMergeCallback */
 /** @typedef {Uint8Array} SignatureBin */
 /** @typedef {Feed|Block|Array<Block>|Uint8Array|ArrayBuffer} Feedlike */
+/** Header offsets of the last scanned block: [author, psig], -1 when absent (f64, feeds may exceed 2GiB) */
+const LAYOUT = new Float64Array(2)
+/**
+ * Reads the layout of a block without allocating
+ * @returns {usize} block size */
+function scanBlock (buf, o) {
+  let size = 0
+  let h = o + 64
+  for (let shift = 0; ; shift += 7) {
+    const b = buf[h++]
+    size |= (b & 0x7F) << shift
+    if (!(b & 0x80)) break
+  }
+  size += h - o
+  if (buf.length < o + size) throw new Error('BufferUnderflow')
+  LAYOUT[0] = LAYOUT[1] = -1
+  while (buf[h] === 0) {
+    const type = buf[h + 1]
+    h += 2
+    switch (type) {
+      case HDR_AUTHOR: LAYOUT[0] = h; h += 32; break
+      case HDR_PSIG: LAYOUT[1] = h; h += 64; break
+      default: h += headerSize(type)
+    }
+  }
+  return size
+}
+
+/** @type {(a: Uint8Array, ai: number, b: Uint8Array, bi: number, n: number) => boolean} */
+function eqAt (a, ai, b, bi, n) {
+  for (let k = 0; k < n; k++) if (a[ai + k] !== b[bi + k]) return false
+  return true
+}
+
+const hasAuthor = b => { scanBlock(b.buffer, 0); return LAYOUT[0] !== -1 }
+
 export class Block { // BlockMapper
   [symBlock] = 8 // v8
   #blksz = 0 // block size
@@ -160,7 +239,6 @@ export class Block { // BlockMapper
     // TODO: move length decode varint after headers
     const [dataSize, vo] = varintDecode(buffer, offset + 64)
     this.#blksz = dataSize + 64 + vo
-    this.#size = dataSize
     if (buffer.length < offset + this.#blksz) throw new Error('BufferUnderflow')
     this.buffer = buffer.subarray(offset, offset + this.#blksz)
     // No more absolute offsets
@@ -173,16 +251,16 @@ export class Block { // BlockMapper
       switch (type) {
         case HDR_AUTHOR:
           this.#key = this.buffer.subarray(this.#bodyOffset, this.#bodyOffset + 32)
-          this.#bodyOffset += 32; this.#size -= 32
+          this.#bodyOffset += 32
           break
         case HDR_PSIG:
           this.#psig = this.buffer.subarray(this.#bodyOffset, this.#bodyOffset + 64)
-          this.#bodyOffset += 64; this.#size -= 64
+          this.#bodyOffset += 64
           break
-        // c8 ignore next
-        default: throw new Error(`DecodedUnknownHeader: ${type}`)
+        default: this.#bodyOffset += headerSize(type)
       }
     }
+    this.#size = this.#blksz - this.#bodyOffset
   }
 
   /** @type {boolean} */
@@ -249,6 +327,7 @@ export class Feed {
   static isFeed = isFeed
   static isBlock = isBlock
   static from = feedFrom
+  static fromAsync = feedFromAsync
   /** @type {number} used bytes in feed */
   tail = 0
 
@@ -275,11 +354,30 @@ export class Feed {
     if (min < size) return false
     while (size < min) size = size << 1
     const arr = new Uint8Array(size)
-    this._buf = cpy(arr, this._buf)
-    this._index(true, true) // invalidate all subarrays.
+    const prev = this._buf
+    this._buf = cpy(arr, prev)
+    if (this._c) this.#rebase(prev)
     return true
   }
 
+  /** Offsets survive the copy, only views of the old memory are dropped */
+  #rebase (prev) {
+    const c = this._c
+    const rebase = k => k?.buffer === prev.buffer
+      ? this._buf.subarray(k.byteOffset - prev.byteOffset, k.byteOffset - prev.byteOffset + k.length)
+      : k
+    c.keys = c.keys.map(rebase)
+    const anon = c.blocks
+    c.blocks = []
+    // anonymous blocks carry a key that is not in the buffer, remap them with it
+    anon.forEach((b, i) => {
+      if (hasAuthor(b)) return
+      const block = new Block(this._buf, c.offsets[i])
+      if (b.key) block.__key = b.key
+      c.blocks[i] = block
+    })
+  }
+
   /** @returns {Uint8Array} access internal memory */
   get buffer () {
     this._index()
@@ -321,53 +419,120 @@ export class Feed {
   /** First block */
   get first () { return this.block(0) }
   /** Length in blocks / height */
-  get length () { return this.blocks.length }
+  get length () {
+    this._index()
+    return this._c.length
+  }
   get partial () { return !this.first?.genesis } // Deprecate?
 
-  /** @type {Array<Block>} */
+  /**
+   * Materializes all blocks, prefer block(n) or iteration on large feeds
+   * @type {Array<Block>} */
   get blocks () {
     this._index()
-    return this._c.blocks
+    const c = this._c
+    for (let i = 0; i < c.length; i++) c.blocks[i] ||= new Block(this._buf, c.offsets[i])
+    return c.blocks
   }
 
-  /** @param {number} n */
+  /**
+   * Block at height n, negative counts from the end
+   * @param {number} n
+   * @returns {Block|undefined} */
   block (n) {
-    const blocks = this.blocks
-    return blocks[n < 0 ? blocks.length + n : n]
+    this._index()
+    const c = this._c
+    if (n < 0) n += c.length
+    if (!(n >= 0 && n < c.length)) return undefined
+    return (c.blocks[n] ||= new Block(this._buf, c.offsets[n]))
   }
 
+  /** Iterates blocks without retaining them
+   * @returns {Generator<Block, void, unknown>} */
+  * [Symbol.iterator] () {
+    const n = this.length
+    for (let i = 0; i < n; i++) yield this._c.blocks[i] || new Block(this._buf, this._c.offsets[i])
+  }
+
+  /** @returns {Array<Block>} blocks [start, end) */
+  _range (start, end) {
+    const out = []
+    for (let i = start; i < end; i++) out.push(this.block(i))
+    return out
+  }
+
+  /**
+   * Indexes new blocks into a compact offset table,
+   * Block objects are created on access.
+   */
   _index (reindex = false, preverified) {
     const skipVerification = preverified === true
     const anonKeyMap = preverified || {} // Currently unused feature but want to support (HDR_AUTHOR is optional)
-    if (!this._c || reindex) this._c = { keys: [], blocks: [], offset: 0 }
+    if (!this._c || reindex) {
+      this._c = { keys: [], blocks: [], offsets: new Float64Array(16), psigs: new Float64Array(16), length: 0, offset: 0 }
+    }
     const c = this._c // cache
+    const buf = this._buf
     // Skip magic @deprecate?
-    if (!c.offset && cmp(this._buf.subarray(0, 4), PIC0)) c.offset = 4
+    if (!c.offset && cmp(buf.subarray(0, 4), PIC0)) c.offset = 4
     if (this.tail < c.offset) this.tail = c.offset
 
+    // Verify ahead in C, leaves anonymous and invalid blocks to the loop below
+    let trusted = 0
+    /* c8 ignore start */ // addon only
+    if (native() && !skipVerification) {
+      const p = c.length ? buf.subarray(c.offsets[c.length - 1], c.offsets[c.length - 1] + 64) : null
+      trusted = native().verify(buf, c.offset, p)
+      if (Feed.__vctr !== -1) Feed.__vctr += trusted
+    }
+    /* c8 ignore stop */
+
     do {
       // Detect end of feed
-      if (this._buf.length - c.offset < 64 + 1 + 1) break // Minimum block size
-      if (!this._buf[c.offset + 64]) break // no data
-      const [assumedSize, vs] = varintDecode(this._buf, c.offset + 64)
-      if (this._buf.length - (c.offset + vs) < assumedSize) break
-
-      // Load block
-      const block = new Block(this._buf, c.offset)
-      const p = c.blocks[c.blocks.length - 1]
-      if (p && !cmp(p.sig, block.psig)) throw new Error('InvalidParent')
-      const known = anonKeyMap[toHex(block.sig)]
-      if (known) block.__key = known // De-anonymize anonymous blocks using provided key
-      if (!skipVerification) {
-        // use embedded HDR_AUTHOR || seek key
-        const valid = block.key
-          ? block.verify()
-          : c.keys.find(k => block.verify(k))
-        if (!valid) throw new Error('InvalidFeed.SignatureVerificationFailed')
+      if (buf.length - c.offset < 64 + 1 + 1) break // Minimum block size
+      if (!buf[c.offset + 64]) break // no data
+      const [assumedSize, vs] = varintDecode(buf, c.offset + 64)
+      if (buf.length - (c.offset + vs) < assumedSize) break
+
+      // Load block layout
+      const o = c.offset
+      const n = c.length
+      const size = scanBlock(buf, o)
+      const author = LAYOUT[0]
+      const psig = LAYOUT[1]
+      if (n && (psig < 0 || !eqAt(buf, c.offsets[n - 1], buf, psig, 64))) throw new Error('InvalidParent')
+
+      let key
+      if (author < 0 || (!trusted && !skipVerification)) {
+        const block = new Block(buf, o)
+        if (author < 0) {
+          const known = anonKeyMap[toHex(block.sig)]
+          if (known) block.__key = known // De-anonymize anonymous blocks using provided key
+          c.blocks[n] = block // keeps the key
+        }
+        if (!trusted && !skipVerification) {
+          // use embedded HDR_AUTHOR || seek key
+          const valid = block.key
+            ? block.verify()
+            : c.keys.find(k => block.verify(k))
+          if (!valid) throw new Error('InvalidFeed.SignatureVerificationFailed')
+        }
+        key = block.key
+      }
+      if (trusted) --trusted
+
+      if (n === c.offsets.length) {
+        c.offsets = cpy(new Float64Array(n << 1), c.offsets)
+        c.psigs = cpy(new Float64Array(n << 1), c.psigs)
       }
-      c.blocks.push(block)
-      c.offset += block.blockSize
-      if (!c.keys.find(k => cmp(k, block.key))) c.keys.push(block.key)
+      c.offsets[n] = o
+      c.psigs[n] = psig
+      c.length++
+      c.offset += size
+      const seen = author < 0
+        ? c.keys.find(k => cmp(k, key))
+        : c.keys.find(k => k?.length === 32 && eqAt(k, 0, buf, author, 32))
+      if (!seen) c.keys.push(author < 0 ? key : buf.subarray(author, author + 32))
       if (this.tail < c.offset) this.tail = c.offset
     } while (1)
   }
@@ -388,11 +553,17 @@ export class Feed {
    */
   truncate (height) {
     if (!Number.isInteger(height)) throw new Error('IntegerExpected') /* c8 ignore next */
-    if (height < 0) height = this.length + height
-    const bs = this.blocks
+    this._index()
+    if (height < 0) height = Math.max(0, this.length + height)
+    const c = this._c
     // ... 🍵
-    while (height < bs.length) this.tail -= bs.pop()._brick()
-    this._c.offset = this.tail
+    while (height < c.length) {
+      const o = c.offsets[--c.length]
+      this._buf[o + 64] = 0 // brick
+      this.tail = o
+    }
+    if (c.blocks.length > c.length) c.blocks.length = c.length
+    c.offset = this.tail
     return this.length
   }
 
@@ -404,28 +575,35 @@ export class Feed {
   diff (other) {
     other = feedFrom(other)
     if (this === other) return 0
-    const a = this.blocks
-    const b = other.blocks
-    if (!a.length) return b.length // A is empty
+    const an = this.length
+    const bn = other.length
+    if (!an) return bn // A is empty
+    if (!bn) return -an // B is empty
+    const a = this._c
+    const b = other._c
+    const A = this._buf
+    const B = other._buf
+    const bpsig = b.psigs[0]
     // Align B to A / Find the common parent block
     let i = 0 // offset
     let j = 0 // shift
-    for (; i < a.length; i++) {
-      if (cmp(a[i].psig, b[j].psig)) break
-      if (cmp(a[i].sig, b[j].psig)) { j--; break }
+    for (; i < an; i++) {
+      const apsig = a.psigs[i]
+      if (apsig < 0 ? bpsig < 0 : bpsig >= 0 && eqAt(A, apsig, B, bpsig, 64)) break
+      if (bpsig >= 0 && eqAt(A, a.offsets[i], B, bpsig, 64)) { j--; break }
     }
-    if (i === a.length) throw new Error('unrelated')
+    if (i === an) throw new Error('unrelated')
     if (j === -1) { // B[0].parent is at A[i]
-      if (i + 1 === a.length) return b.length // all new
+      if (i + 1 === an) return bn // all new
       else { ++i; ++j } // forward one step
     }
     // Compare the blocks after the common parent
-    for (; i < a.length && j < b.length; (i++, j++)) {
-      if (!cmp(a[i].sig, b[j].sig)) throw new Error('diverged')
+    for (; i < an && j < bn; (i++, j++)) {
+      if (!eqAt(A, a.offsets[i], B, b.offsets[j], 64)) throw new Error('diverged')
     }
-    if (i === a.length && j === b.length) return 0 // Eql len, eql blocks
-    else if (i === a.length) return b.length - j // A exhausted, remain B
-    else return i - a.length // B exhausted, remain A
+    if (i === an && j === bn) return 0 // Eql len, eql blocks
+    else if (i === an) return bn - j // A exhausted, remain B
+    else return i - an // B exhausted, remain A
   }
 
   /**
@@ -436,9 +614,9 @@ export class Feed {
    * @returns {Feed} Slice of blocks + keys
    */
   slice (start = 0, end = this.length) {
-    const blocks = this.blocks
-      .slice(start < 0 ? this.length + start : start, end)
-    return feedFrom(blocks)
+    const n = this.length
+    const norm = x => Math.max(0, Math.min(n, x < 0 ? n + x : x))
+    return feedFrom(this._range(norm(start), norm(end)))
   }
 
   /**
@@ -470,7 +648,7 @@ export class Feed {
       }
     }
     if (s < 1) return 0 // no new blocks, abort.
-    const blocks = src.blocks.slice(src.length - s, src.length)
+    const blocks = src._range(src.length - s, src.length)
     let m = 0
     let stop = false
     for (const b of dst._rebase(blocks)) {
@@ -544,6 +722,90 @@ export function feedFrom (input, noVerify = false) {
   throw new Error(`Cannot create feed from: ${typeof input}`)
 }
 
+/** Minimum blocks per worker in feedFromAsync() */
+const ASYNC_MIN_BLOCKS = 64
+
+/**
+ * Like `feedFrom()` but verifies signatures on worker threads,
+ * keeping the event loop free while large feeds are loaded.
+ *
+ * Bytes are copied once into shared memory, the calling thread checks
+ * structure and PSIG linkage, each worker checks signatures of one range.
+ * Falls back to `feedFrom()` outside of node, for small feeds and
+ * for feeds with anonymous blocks.
+ *
+ * @param {Feedlike} input
+ * @param {{ workers?: number, noVerify?: boolean }} [options]
+ * @return {Promise<Feed>}
+ */
+export async function feedFromAsync (input, options = {}) {
+  const { noVerify = false } = options
+  const bytes = ArrayBuffer.isView(input) || input instanceof ArrayBuffer
+  const threads = bytes && !noVerify && await nodeImport('node:worker_threads')
+  if (!threads) return feedFrom(input, noVerify)
+
+  const src = toU8(input)
+  const n = countBlocks(src)
+  const os = await nodeImport('node:os')
+  const cores = os.availableParallelism?.() ?? os.cpus().length
+  const workers = Math.min(options.workers ?? cores, Math.floor(n / ASYNC_MIN_BLOCKS))
+  if (workers < 2) return feedFrom(src)
+
+  const shared = new Uint8Array(new SharedArrayBuffer(src.length))
+  shared.set(src)
+  const feed = new Feed(shared, true) // throws InvalidParent
+  const c = feed._c
+  if (feed.keys.some(k => !k)) return feedFrom(src)
+
+  const per = Math.ceil(c.length / workers)
+  const pool = []
+  const jobs = []
+  for (let i = 0; i < c.length; i += per) {
+    const count = Math.min(per, c.length - i)
+    const start = c.offsets[i]
+    const end = i + count < c.length ? c.offsets[i + count] : c.offset
+    const worker = new threads.Worker(new URL('./worker.js', import.meta.url), {
+      workerData: { buffer: shared.buffer, start, end }
+    })
+    pool.push(worker)
+    jobs.push(workerResult(worker).then(valid => {
+      if (Feed.__vctr !== -1) Feed.__vctr += Math.min(count, valid + 1)
+      if (valid < count) throw new Error('InvalidFeed.SignatureVerificationFailed')
+    }))
+  }
+  try {
+    await Promise.all(jobs)
+  } catch (err) {
+    for (const worker of pool) worker.terminate() // first failure decides
+    throw err
+  }
+  return feed
+}
+
+/** Counts blocks by their size prefix without scanning headers
+ * @type {(buf: Uint8Array) => number} */
+function countBlocks (buf) {
+  let o = buf.length >= 4 && cmp(buf.subarray(0, 4), PIC0) ? 4 : 0
+  let n = 0
+  while (buf.length - o >= 64 + 1 + 1 && buf[o + 64]) {
+    const varint = varintDecode(buf, o + 64)
+    if (!varint) break
+    o += 64 + varint[1] + varint[0]
+    if (o > buf.length) break
+    n++
+  }
+  return n
+}
+
+/** @returns {Promise<number>} number of leading valid blocks reported by the worker */
+function workerResult (worker) {
+  return new Promise((resolve, reject) => {
+    worker.once('message', resolve)
+    worker.once('error', reject)
+    worker.once('exit', code => reject(new Error(`WorkerExit: ${code}`)))
+  })
+}
+
 // TODO: Move somewhere else
 export function macrofilm (f, w = 40, m = 32) {
   const h = (w - 6) / 2
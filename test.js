@@ -1,4 +1,6 @@
 import { webcrypto } from 'node:crypto'
+import { createRequire } from 'node:module'
+import { ed25519 } from '@noble/curves/ed25519'
 import { test, skip } from 'brittle'
 import {
   Feed,
@@ -7,6 +9,7 @@ import {
   Block,
   toHex,
   b2s,
+  s2b,
   toU8,
   fromHex,
   getPublicKey,
@@ -348,6 +351,170 @@ test('reverse diverged merge', async t => {
   t.is(b.slice(-1).merge(a), -1, 'reverse diverged')
 })
 
+// Shared with c/test/picofeed_test.c
+const FEED_B0_B1_HEX = '504943309e18cace6e020264ca63836eabb453696b35546b5e0a79ee1da05e52' +
+  'dccd5e2bfad7bb51c03be7ea2aabe47db06f97c707e9656acf8cb83a34528340' +
+  'ebe188052400017f27cc492c272e24f1a1428dd528c9f089f36a3d17aa469595' +
+  '8601104d61792e42302c64c8f442a8af65fbedad20ea15b50b60e5554d51ecdb' +
+  '332c661fd708c1a74823fac5db71fe891d9de43ed2e2a3955e64efad5602fd15' +
+  '303c42b768a2620d096600017f27cc492c272e24f1a1428dd528c9f089f36a3d' +
+  '17aa4695958601104d61792e00029e18cace6e020264ca63836eabb453696b35' +
+  '546b5e0a79ee1da05e52dccd5e2bfad7bb51c03be7ea2aabe47db06f97c707e9' +
+  '656acf8cb83a34528340ebe188054231'
+
+test('vectors: feed bytes', t => {
+  const sk = 'f1d0ea8c8dc3afca9766ee6104f02b6ea427f1d24e3e4d6813b09946dff11dfa'
+  const f = new Feed()
+  f.append('B0', sk)
+  f.append('B1', sk)
+  t.is(toHex(f.buffer), FEED_B0_B1_HEX, 'append matches C')
+})
+
+// B0, B1, B2 written by the C engine with skip links, B2 carries HDR_SKIP (0x7F) to B0
+const FEED_SKIP_HEX = '504943309e18cace6e020264ca63836eabb453696b35546b5e0a79ee1da05e52' +
+  'dccd5e2bfad7bb51c03be7ea2aabe47db06f97c707e9656acf8cb83a34528340' +
+  'ebe188052400017f27cc492c272e24f1a1428dd528c9f089f36a3d17aa469595' +
+  '8601104d61792e42302c64c8f442a8af65fbedad20ea15b50b60e5554d51ecdb' +
+  '332c661fd708c1a74823fac5db71fe891d9de43ed2e2a3955e64efad5602fd15' +
+  '303c42b768a2620d096600017f27cc492c272e24f1a1428dd528c9f089f36a3d' +
+  '17aa4695958601104d61792e00029e18cace6e020264ca63836eabb453696b35' +
+  '546b5e0a79ee1da05e52dccd5e2bfad7bb51c03be7ea2aabe47db06f97c707e9' +
+  '656acf8cb83a34528340ebe1880542318d6597a0f4e96af51fb0092f36f25895' +
+  'df8167c262a740f5a1c36eb53016fa5e3a790ef965bcca426226c60db6f72808' +
+  'd328d6294acf21c3ffc714c6d7a1320ca80100017f27cc492c272e24f1a1428d' +
+  'd528c9f089f36a3d17aa4695958601104d61792e00022c64c8f442a8af65fbed' +
+  'ad20ea15b50b60e5554d51ecdb332c661fd708c1a74823fac5db71fe891d9de4' +
+  '3ed2e2a3955e64efad5602fd15303c42b768a2620d09007f9e18cace6e020264' +
+  'ca63836eabb453696b35546b5e0a79ee1da05e52dccd5e2bfad7bb51c03be7ea' +
+  '2aabe47db06f97c707e9656acf8cb83a34528340ebe188054232'
+
+test('vectors: skips size-class headers', t => {
+  const f = Feed.from(fromHex(FEED_SKIP_HEX))
+  t.is(f.length, 3, 'all blocks verified')
+  t.alike(f.blocks.map(b => b2s(b.body)), ['B0', 'B1', 'B2'], 'bodies intact')
+  t.is(f.blocks[2].size, 2, 'body size excludes headers')
+  t.is(toHex(f.blocks[2].psig), toHex(f.blocks[1].sig), 'psig found after skip header')
+  const trusted = Feed.from(fromHex(FEED_SKIP_HEX), true)
+  t.is(toHex(trusted.block(2).key), getPublicKey('f1d0ea8c8dc3afca9766ee6104f02b6ea427f1d24e3e4d6813b09946dff11dfa'), 'lazy index reads author')
+  const bad = fromHex(FEED_SKIP_HEX)
+  bad[bad.length - 67] = 0x80
+  t.exception(() => Feed.from(bad, true).block(2), /DecodedUnknownHeader: 128/, 'application headers still rejected')
+})
+
+/** @returns {any} the addon when built and enabled, null otherwise */
+function loadNative () {
+  if (process.env.PICOFEED_NATIVE === '0') return null
+  try { return createRequire(import.meta.url)('./c/build/Release/picofeed.node') } catch (_) { return null }
+}
+const native = loadNative()
+const ntest = native ? test : skip
+
+const rtest = globalThis.process?.features?.require_module ? test : skip
+rtest('native: require() works without top-level await', t => {
+  const mod = createRequire(import.meta.url)('./index.js')
+  t.is(typeof mod.Feed, 'function', 'loaded synchronously')
+  t.absent('native' in mod, 'addon not exported')
+})
+ntest('native: addon matches JS', t => {
+  const sk = fromHex('f1d0ea8c8dc3afca9766ee6104f02b6ea427f1d24e3e4d6813b09946dff11dfa')
+  t.is(toHex(native.publicKey(sk)), getPublicKey(sk), 'public key')
+
+  let bytes = new Feed().buffer
+  bytes = native.append(bytes, s2b('B0'), sk)
+  bytes = native.append(bytes, s2b('B1'), sk)
+  t.is(toHex(bytes), FEED_B0_B1_HEX, 'append is byte-identical')
+  const msg = s2b('msg')
+  t.is(toHex(native.sign(msg, sk, new Uint8Array(32))), toHex(ed25519.sign(msg, sk)), 'caller pk ignored')
+  t.is(native.verify(bytes, 4, null), 2, 'blocks verify')
+  const bad = bytes.slice()
+  bad[bad.length - 1] ^= 1
+  t.is(native.verify(bad, 4, null), 1, 'stops at tampered block')
+
+  const a = Feed.from(bytes)
+  const d = native.decode(a.block(1).buffer)
+  t.is(d.blockSize, a.block(1).blockSize, 'decoded size')
+  t.is(b2s(a.block(1).buffer.subarray(d.bodyStart, d.bodyEnd)), 'B1', 'decoded body')
+  t.is(d.psig, 64 + 1 + 34 + 2, 'decoded psig offset')
+
+  const b = a.clone()
+  b.append('B2', sk)
+  t.is(native.diff(a.buffer, b.buffer), a.diff(b), 'diff ahead')
+  t.is(native.diff(b.buffer, a.buffer), b.diff(a), 'diff behind')
+  t.is(toHex(native.slice(b.buffer, 1, 3)), toHex(b.slice(1, 3).buffer), 'slice')
+  const c = a.clone()
+  c.append('C2', sk)
+  t.exception(() => native.diff(b.buffer, c.buffer), 'diverged')
+})
+
+test('lazy index: block(n), iteration & growth', t => {
+  const { sk } = Feed.signPair()
+  const f = new Feed(128)
+  for (let i = 0; i < 40; i++) f.append(`msg${i}`, sk)
+  t.is(f.length, 40, 'indexed')
+  const before = f.block(10)
+  t.is(b2s(before.body), 'msg10', 'block(n)')
+  t.is(f.block(-1), f.last, 'materialized once')
+  t.ok(f.block(40) === undefined && f.block(-41) === undefined, 'out of range')
+
+  const bodies = []
+  for (const b of f) bodies.push(b2s(b.body))
+  t.is(bodies.join(), Array.from({ length: 40 }, (_, i) => `msg${i}`).join(), 'iterated in order')
+  t.ok(Object.keys(f._c.blocks).length < 40, 'iteration does not retain blocks')
+
+  for (let i = 40; i < 80; i++) f.append(`msg${i}`, sk) // grows a few times
+  t.is(b2s(f.block(10).body), 'msg10', 'offsets survive growth')
+  t.ok(f.block(10).buffer.buffer === f._buf.buffer, 'rebased onto new memory')
+  t.is(f.keys.length, 1, 'keys kept')
+  t.ok(f.keys[0].buffer === f._buf.buffer, 'keys rebased')
+  t.is(Feed.from(f.buffer).length, 80, 'reloads')
+  t.is(f.truncate(-100), 0, 'truncate clamps')
+})
+
+test('truncate() indexes fresh and merged feeds', async t => {
+  const { sk } = Feed.signPair()
+  t.is(new Feed().truncate(0), 0, 'fresh feed')
+  const a = new Feed()
+  for (let i = 0; i < 3; i++) a.append(`B${i}`, sk)
+  const b = a.slice(1)
+  b.merge(a.slice(0, 1)) // reverse merge drops the index
+  t.is(b.truncate(2), 2, 'truncated after merge')
+  t.is(b2s(b.last.body), 'B1')
+})
+
+test('anonymous blocks are remapped on growth', async t => {
+  const { sk } = Feed.signPair()
+  const buf = new Uint8Array(4 + 200)
+  buf.set(s2b('PIC0'))
+  createBlockSegment(buf, 4, 'anon', sk)
+  const f = new Feed(buf, true)
+  t.is(f.length, 1)
+  for (let i = 0; i < 20; i++) f.append(`msg${i}`, sk) // grows
+  const anon = f.block(0)
+  t.ok(anon.buffer.buffer === f._buf.buffer, 'rebased onto new memory')
+  t.is(b2s(anon.body), 'anon')
+})
+
+test('Feed.fromAsync() verifies on workers', async t => {
+  const { sk } = Feed.signPair()
+  const f = new Feed()
+  for (let i = 0; i < 300; i++) f.append(`block${i}`, sk)
+
+  const g = await Feed.fromAsync(f.buffer, { workers: 3 })
+  t.is(g.length, 300, 'indexed')
+  t.is(g.diff(f), 0, 'equal feeds')
+  t.is(b2s(g.block(299).body), 'block299', 'blocks readable')
+  t.is(g.append('more', sk), 301, 'appendable')
+
+  const bad = f.buffer.slice()
+  const b = f.block(200)
+  bad[b.buffer.byteOffset - f.buffer.byteOffset + b.blockSize - 1] ^= 1
+  await t.exception(Feed.fromAsync(bad, { workers: 3 }), 'tampered block rejected')
+
+  const small = await Feed.fromAsync(f.slice(0, 2).buffer)
+  t.is(small.length, 2, 'small feeds load synchronously')
+  t.is(await Feed.fromAsync(f), f, 'feeds pass through')
+})
+
 test('about: verifications', async t => {
   let n = Feed.__vctr
   const nDiffReset = () => { const r = Feed.__vctr - n; n = Feed.__vctr; return r }
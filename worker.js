@@ -0,0 +1,24 @@
+// Verifies signatures of one block range for feedFromAsync()
+import { createRequire } from 'node:module'
+import { parentPort, workerData } from 'node:worker_threads'
+import { Block } from './index.js'
+
+let native = null // same addon and switch as index.js
+/* c8 ignore start */ // addon only, see native() in index.js
+if (process.env.PICOFEED_NATIVE !== '0') {
+  try { native = createRequire(import.meta.url)('./c/build/Release/picofeed.node') } catch (_) {}
+}
+/* c8 ignore stop */
+
+const { buffer, start, end } = workerData
+const bytes = new Uint8Array(buffer, 0, end)
+let valid = 0
+if (native) valid = native.verify(bytes, start, null) // linkage was checked by caller
+else {
+  for (let o = start; o < end; valid++) {
+    const block = new Block(bytes, o)
+    if (!block.verify()) break
+    o += block.blockSize
+  }
+}
+parentPort.postMessage(valid)